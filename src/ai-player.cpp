@@ -1,31 +1,81 @@
 #include "ai-player.h"
 
+#include <cassert>
 #include <iostream>
-#include <list>
+#include <thread>
 
-using std::list;
+/** How long the player thinks about a move, unless told otherwise. */
+static const int DEFAULT_MILLISECONDS = 1000;
 
-AiPlayer::AiPlayer()
+/** How big the transposition table is, unless told otherwise. */
+static const size_t DEFAULT_HASH_MB = 32;
+
+AiPlayer::AiPlayer() : table_(DEFAULT_HASH_MB), stop_(false),
+    random_(std::random_device()())
 {
+    limits_.milliseconds = DEFAULT_MILLISECONDS;
+
+    // This may not be known, in which case it's 0
+    setThreads(std::thread::hardware_concurrency());
 }
 
 AiPlayer::~AiPlayer()
 {
 }
 
+void AiPlayer::setLimits(const SearchLimits& limits)
+{
+    limits_ = limits;
+}
+
+void AiPlayer::setParams(const SearchParams& params)
+{
+    params_ = params;
+}
+
+void AiPlayer::setHashSize(size_t megabytes)
+{
+    table_.resize(megabytes);
+}
+
+void AiPlayer::setThreads(int num_threads)
+{
+    histories_.resize((num_threads > 1) ? num_threads : 1);
+}
+
+bool AiPlayer::setBook(const std::string& path)
+{
+    if(path.empty())
+    {
+        book_.close();
+        return true;
+    }
+
+    return book_.open(path);
+}
+
 Move AiPlayer::requestMove(bool color, const Board& board)
 {
-    list<Move> moves = board.generatePseudoLegalMoves(color);
+    assert(color == board.whoseTurn());
 
-    list<Move>::const_iterator it;
-    for(it = moves.begin(); it != moves.end(); it++)
+    // A book move is as quick as a move gets, so it answers an interrupt too
+    Move book_move = book_.pickMove(board, random_());
+    if(book_move != Move())
     {
-        if(board.isLegalMove(*it))
-        {
-            return *it;
-        }
+        stop_ = false;
+        return book_move;
     }
 
+    // The flag is only cleared after searching, so that an interrupt that
+    // comes just before the search starts isn't lost
+    table_.newSearch();
+    SearchResult result = parallelSearch(board, table_, histories_, limits_,
+            params_, stop_);
+    stop_ = false;
+
+    if(result.best_move != Move())
+        return result.best_move;
+
     // TODO how do I cleanly end the game?
     std::cout << "Checkmate" << std::endl;
     return Move();
@@ -33,6 +83,5 @@ Move AiPlayer::requestMove(bool color, const Board& board)
 
 void AiPlayer::interrupt()
 {
-    // TODO this should do something once the AI gets slower...
-    return;
+    stop_ = true;
 }
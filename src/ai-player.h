@@ -1,11 +1,28 @@
 #ifndef CHESS_AIPLAYER_H
 #define CHESS_AIPLAYER_H
 
+#include <atomic>
+#include <random>
+#include <string>
+#include <vector>
+
 #include "board.h"
+#include "history.h"
 #include "move.h"
+#include "opening-book.h"
 #include "player-interface.h"
+#include "search.h"
+#include "transposition-table.h"
 
-// TODO make a class comment once your AI isn't terrible
+/**
+ * A computer player. It picks its moves with an alpha-beta Search, thinking
+ * for as long as its limits allow (by default, a second per move). What it
+ * learns about positions is kept in a transposition table from move to move,
+ * and what it learns about moves in a history for each thread.
+ * It searches on as many threads as the machine has cores, unless told
+ * otherwise. If it has an opening book, it plays from that instead, as long
+ * as the position is in the book.
+ */
 class AiPlayer : public PlayerInterface
 {
   public:
@@ -15,16 +32,62 @@ class AiPlayer : public PlayerInterface
     /** Default destructor. */
     ~AiPlayer();
 
+    /** Sets how long the player may think about each move. */
+    void setLimits(const SearchLimits& limits);
+
+    /** Sets the parameters of the search's pruning. */
+    void setParams(const SearchParams& params);
+
+    /**
+     * Sets the size of the transposition table, in megabytes, and clears it.
+     * Mustn't be called during requestMove.
+     */
+    void setHashSize(size_t megabytes);
+
+    /**
+     * Sets how many threads to search on (at least one). Mustn't be called
+     * during requestMove.
+     */
+    void setThreads(int num_threads);
+
     /**
-     * Given a board state, picks the first move it can find for the given
-     * color.
+     * Opens the opening book in the given file, or closes the book if the
+     * path is empty. Returns false, leaving the player without a book, if the
+     * file isn't one. Mustn't be called during requestMove.
+     */
+    bool setBook(const std::string& path);
+
+    /**
+     * Given a board state, searches for the best move for the given color,
+     * who must be the side to move.
      */
     virtual Move requestMove(bool color, const Board& board);
 
-    /** For now, does nothing. */
+    /**
+     * Stops the search in requestMove, which then returns the best move it
+     * has found so far. This returns at once, and the search notices within
+     * a few milliseconds. If no search is running, the next requestMove
+     * returns at once instead.
+     */
     virtual void interrupt();
 
   private:
+    /** How long to think about each move, and how to prune the search. */
+    SearchLimits limits_;
+    SearchParams params_;
+
+    /** The results of searching positions, kept between moves. */
+    TranspositionTable table_;
+
+    /** The history of each search thread, so as many as there are threads. */
+    std::vector<History> histories_;
+
+    /** Tells all the search threads to stop. */
+    std::atomic<bool> stop_;
+
+    /** The opening book, and where the choices between its moves come from. */
+    OpeningBook book_;
+    std::mt19937_64 random_;
 };
 
 #endif
@@ -0,0 +1,182 @@
+#ifndef CHESS_BITBOARD_H
+#define CHESS_BITBOARD_H
+
+#include <cstdint>
+
+#include "common.h"
+
+/**
+ * A set of squares, one bit per square. Since a square is (z << 6) | (y << 3)
+ * | x, each of the eight words holds exactly one z-level, and moving a whole
+ * set one level up or down is just moving the words.
+ */
+class Bitboard
+{
+  public:
+    /** Constructs the empty set. */
+    Bitboard()
+    {
+        for(int z = 0; z < 8; z++)
+            words_[z] = 0;
+    }
+
+    /** Returns the set holding just the given square. */
+    static Bitboard square(int sq)
+    {
+        Bitboard b;
+        b.set(sq);
+        return b;
+    }
+
+    /** Returns the set of all 64 squares on the given z-level. */
+    static Bitboard level(int z)
+    {
+        Bitboard b;
+        b.words_[z] = ~0ULL;
+        return b;
+    }
+
+
+    /** Returns true if the square is in the set. */
+    bool test(int sq) const
+    {
+        return (words_[sq >> 6] >> (sq & 63)) & 1;
+    }
+
+    /** Adds the square to the set. */
+    void set(int sq)
+    {
+        words_[sq >> 6] |= 1ULL << (sq & 63);
+    }
+
+    /** Removes the square from the set. */
+    void clear(int sq)
+    {
+        words_[sq >> 6] &= ~(1ULL << (sq & 63));
+    }
+
+    /** Returns the squares on the given z-level, as in words_. */
+    uint64_t word(int z) const
+    {
+        return words_[z];
+    }
+
+    /** Returns true if there are no squares in the set. */
+    bool empty() const
+    {
+        uint64_t any = 0;
+        for(int z = 0; z < 8; z++)
+            any |= words_[z];
+        return any == 0;
+    }
+
+    /** Returns how many squares are in the set. */
+    int count() const
+    {
+        int n = 0;
+        for(int z = 0; z < 8; z++)
+            n += __builtin_popcountll(words_[z]);
+        return n;
+    }
+
+    /** Returns the lowest square in a non-empty set. */
+    int lowest() const
+    {
+        int z = 0;
+        while(words_[z] == 0)
+            z++;
+
+        return (z << 6) | __builtin_ctzll(words_[z]);
+    }
+
+    /** Returns the highest square in a non-empty set. */
+    int highest() const
+    {
+        int z = 7;
+        while(words_[z] == 0)
+            z--;
+
+        return (z << 6) | (63 - __builtin_clzll(words_[z]));
+    }
+
+    /** Removes the lowest square from a non-empty set, and returns it. */
+    int popLowest()
+    {
+        int sq = lowest();
+        words_[sq >> 6] &= words_[sq >> 6] - 1;
+        return sq;
+    }
+
+
+    /** Returns the set moved one level up (+z). The top level falls off. */
+    Bitboard up() const
+    {
+        Bitboard b;
+        for(int z = 1; z < 8; z++)
+            b.words_[z] = words_[z - 1];
+        return b;
+    }
+
+    /** Returns the set moved one level down (-z). The bottom level drops. */
+    Bitboard down() const
+    {
+        Bitboard b;
+        for(int z = 0; z < 7; z++)
+            b.words_[z] = words_[z + 1];
+        return b;
+    }
+
+
+    /** The usual set operations. */
+    Bitboard operator~() const
+    {
+        Bitboard b;
+        for(int z = 0; z < 8; z++)
+            b.words_[z] = ~words_[z];
+        return b;
+    }
+
+    Bitboard& operator&=(const Bitboard& o)
+    {
+        for(int z = 0; z < 8; z++)
+            words_[z] &= o.words_[z];
+        return *this;
+    }
+
+    Bitboard& operator|=(const Bitboard& o)
+    {
+        for(int z = 0; z < 8; z++)
+            words_[z] |= o.words_[z];
+        return *this;
+    }
+
+    Bitboard& operator^=(const Bitboard& o)
+    {
+        for(int z = 0; z < 8; z++)
+            words_[z] ^= o.words_[z];
+        return *this;
+    }
+
+    Bitboard operator&(const Bitboard& o) const { return Bitboard(*this) &= o; }
+    Bitboard operator|(const Bitboard& o) const { return Bitboard(*this) |= o; }
+    Bitboard operator^(const Bitboard& o) const { return Bitboard(*this) ^= o; }
+
+    bool operator==(const Bitboard& o) const
+    {
+        for(int z = 0; z < 8; z++)
+            if(words_[z] != o.words_[z])
+                return false;
+        return true;
+    }
+
+    bool operator!=(const Bitboard& o) const
+    {
+        return !(*this == o);
+    }
+
+  private:
+    /** The squares on each z-level. Bit n of word z is square (z << 6) | n. */
+    uint64_t words_ [8];
+};
+
+#endif
@@ -1,27 +1,26 @@
 #include "board.h"
 
-using std::list;
-using std::stack;
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#include "geometry.h"
+#include "notation.h"
+#include "zobrist.h"
+
+using std::string;
+using std::vector;
 
 /*
  * The following lookup tables are all indexed by PieceType. If the order of
  * them changes, make sure to update this as well.
  */
 
-/**
- * This array just tells you how long the relevant row of
- * PIECE_DIRECTIONS is (the rest is garbage).
- */
-static const int NUM_DIRECTIONS [16] = {
-    0, 0, 8, 8,
-    24, 24, 24, 72,
-    6, 12, 8,
-    18, 20, 14,
-    26, 26
-};
-
 /** Whether the indexing piece is a sliding piece. */
-static const bool SLIDING [16] = {
+static constexpr bool SLIDING [16] = {
     0, 0, 0, 0,
     0, 0, 0, 0,
     1, 1, 1,
@@ -30,66 +29,48 @@ static const bool SLIDING [16] = {
 };
 
 /**
- * The directions that the indexing piece can move in. Since the pieces are
- * stored in a linear array, we can encode an offset triple (x,y,z) as a
- * single integer offset.
+ * For each PieceType, which families of rays it slides along: bit 0 for the
+ * rook lines, bit 1 for the bishop lines and bit 2 for the mace lines. These
+ * are the first 6, next 12 and last 8 lines in Geometry.
  */
-static const int PIECE_DIRECTIONS [16][72] = {
-    /* NIL, BORDER */
-    {}, {},
-
-    /* W_PAWN - Captures only */
-    {157, 156, 155, 145, 143, 133, 132, 131},
-    /* B_PAWN - Captures only */
-    {-157,-156,-155,-145,-143,-133,-132,-131},
-
-
-    /* KNIGHT */
-    {  14,  10,  25,  23, 146, 142, 289, 287, 168, 120, 300, 276,
-      -14, -10, -25, -23,-146,-142,-289,-287,-168,-120,-300,-276},
-    /* GRIFFIN */
-    { 158, 154, 134, 130, 169, 121, 167, 119, 301, 275, 299, 277,
-     -158,-154,-134,-130,-169,-121,-167,-119,-301,-275,-299,-277},
-    /* DRAGON */
-    { 313, 311, 265, 263, 302, 278, 298, 274, 170, 118, 166, 122,
-     -313,-311,-265,-263,-302,-278,-298,-274,-170,-118,-166,-122},
-    /* UNICORN */
-    {  14,  10,  25,  23, 146, 142, 289, 287, 168, 120, 300, 276,
-      -14, -10, -25, -23,-146,-142,-289,-287,-168,-120,-300,-276,
-      158, 154, 134, 130, 169, 121, 167, 119, 301, 275, 299, 277,
-     -158,-154,-134,-130,-169,-121,-167,-119,-301,-275,-299,-277,
-      313, 311, 265, 263, 302, 278, 298, 274, 170, 118, 166, 122,
-     -313,-311,-265,-263,-302,-278,-298,-274,-170,-118,-166,-122},
-
-    /* ROOK */
-    {1, 12, 144, -1, -12, -144},
-    /* BISHOP */
-    {13, 11, 145, 143, 156, 132, -13, -11, -145, -143, -156, -132},
-    /* MACE */
-    {157, 155, 133, 131, -157, -155, -133, -131},
-
-    /* WIZARD */
-    {1, 12, 144, -1, -12, -144,
-     13, 11, 145, 143, 156, 132, -13, -11, -145, -143, -156, -132},
-    /* ARCHER */
-    {13, 11, 145, 143, 156, 132, -13, -11, -145, -143, -156, -132,
-     157, 155, 133, 131, -157, -155, -133, -131},
-    /* CANNON */
-    {1, 12, 144, -1, -12, -144,
-     157, 155, 133, 131, -157, -155, -133, -131},
-
-    /* QUEEN */
-    {1, 12, 144, -1, -12, -144,
-     13, 11, 145, 143, 156, 132, -13, -11, -145, -143, -156, -132,
-     157, 155, 133, 131, -157, -155, -133, -131},
-    /* KING */
-    {1, 12, 144, -1, -12, -144,
-     13, 11, 145, 143, 156, 132, -13, -11, -145, -143, -156, -132,
-     157, 155, 133, 131, -157, -155, -133, -131}
+static constexpr int SLIDER_LINES [16] = {
+    0, 0, 0, 0,
+    0, 0, 0, 0,
+    1, 2, 4,
+    3, 6, 5,
+    7, 0
 };
 
 /** Represents the lack of an en passant square for the turn. */
-const int NO_EP_SQUARE = 0;
+const int NO_EP_SQUARE = -1;
+
+/** Marks a state whose GameState hasn't been worked out yet. */
+static const signed char UNKNOWN_STATE = -1;
+
+/** Every side starts with all its castling rights. */
+static const unsigned short ALL_CASTLING_RIGHTS = 0x0FFF;
+
+/**
+ * How many plies of state a board reserves room for up front. Games and
+ * searches rarely go past this, so makeMove almost never has to reallocate.
+ */
+static const int RESERVED_PLIES = 1024;
+
+/**
+ * Represents a missing square, such as that of a king that isn't on the
+ * board. It's not an index into pieces_, so it's never mistaken for a real
+ * one.
+ */
+const int NO_SQUARE = -1;
+
+/**
+ * Flags used by generateLegalMoves to mark squares. The low bits hold which
+ * pin ray (1 to 26) a square is on, if any. CHECK_RAY marks the squares that
+ * would stop a check: the checking piece, and anything between it and the
+ * king.
+ */
+static const unsigned char PIN_RAY = 0x1F;
+static const unsigned char CHECK_RAY = 0x80;
 
 /** Describes the initial setup of the back rank. */
 static const PieceType INITIAL_SETUP [8][8] = {
@@ -109,13 +90,13 @@ static const PieceType INITIAL_SETUP [8][8] = {
 static int kingSquare(bool color)
 {
     int z = (color == WHITE) ? 0 : 7;
-    return mailbox(4,4,z);
+    return squareAt(4,4,z);
 }
 
 /** Returns the direction along which the king castles. */
 static int castleDir(int axis)
 {
-    int array [6] = {1, 12, 13, -1, -12, -13};
+    int array [6] = {1, 8, 9, -1, -8, -9};
     return array[axis];
 }
 
@@ -141,50 +122,237 @@ static int castleMask(bool color, int axis)
  */
 static int castleMaskAll(bool color)
 {
-   return (color == WHITE) ? 0x3F : 0xFC;
+   return (color == WHITE) ? 0x3F : 0xFC0;
+}
+
+/** Returns the Zobrist key for an en passant square, which may be absent. */
+static uint64_t enPassantKey(int square)
+{
+    if(square == NO_EP_SQUARE)
+        return 0;
+    return Zobrist::enPassant(square);
+}
+
+/** Returns true if p is an actual piece, rather than NIL or BORDER. */
+static bool isPiece(const Piece& p)
+{
+    return p.type() != NIL && p.type() != BORDER;
+}
+
+/** Returns true if p is a pawn of either color. */
+static bool isPawn(const Piece& p)
+{
+    return p.type() == W_PAWN || p.type() == B_PAWN;
+}
+
+/** Returns which bit of SLIDER_LINES the given line belongs to. */
+static int lineOfDirection(int dir)
+{
+    return (dir < BISHOP_LINES) ? 1 : (dir < MACE_LINES) ? 2 : 4;
+}
+
+/**
+ * Returns the squares a piece of type PT attacks from origin, given which
+ * squares are occupied. Sliders stop at (and include) the first piece they
+ * meet in each direction. Since PT is fixed, the checks on it all vanish, and
+ * only the loops over the piece's own lines are left.
+ */
+template<PieceType PT>
+static Bitboard attacksFrom(int origin, const Bitboard& occupied)
+{
+    if(!SLIDING[PT])
+        return Geometry::leaps(PT, origin);
+
+    Bitboard attacks;
+    if(SLIDER_LINES[PT] & 1)
+        for(int dir = 0; dir < BISHOP_LINES; dir++)
+            attacks |= Geometry::slide(origin, dir, occupied);
+    if(SLIDER_LINES[PT] & 2)
+        for(int dir = BISHOP_LINES; dir < MACE_LINES; dir++)
+            attacks |= Geometry::slide(origin, dir, occupied);
+    if(SLIDER_LINES[PT] & 4)
+        for(int dir = MACE_LINES; dir < NUM_LINES; dir++)
+            attacks |= Geometry::slide(origin, dir, occupied);
+    return attacks;
+}
+
+/** Returns the given set of squares moved one rank forward for COLOR. */
+template<bool COLOR>
+static Bitboard forward(const Bitboard& squares)
+{
+    return (COLOR == WHITE) ? squares.up() : squares.down();
 }
 
 //----CLASS METHODS----
 
 Board::Board()
 {
-    for(int i = 0; i < 1728; i++)
-        pieces_[i] = Piece(BORDER, WHITE);
-
-    for(int i = 0; i < 8; i++)
-        for(int j = 0; j < 8; j++)
-            for(int k = 0; k < 8; k++)
-                pieces_[mailbox(i, j, k)] = Piece(NIL, WHITE);
+    for(int i = 0; i < NUM_SQUARES; i++)
+        pieces_[i] = Piece(NIL, WHITE);
 
-    ep_locations_.push(NO_EP_SQUARE);
-    castling_rights_.push(0x0FFF);
+    clearPieceLists();
+    first_turn_ = WHITE;
+    resetStates();
 }
 
 void Board::setup()
 {
+    for(int i = 0; i < NUM_SQUARES; i++)
+        pieces_[i] = Piece(NIL, WHITE);
+
+    clearPieceLists();
+
     for(int i = 0; i < 8; i++)
     {
         for(int j = 0; j < 8; j++)
         {
             PieceType pt = INITIAL_SETUP[i][j];
-            pieces_[mailbox(i,j,0)] = Piece(pt, WHITE);
-            pieces_[mailbox(i,j,1)] = Piece(W_PAWN, WHITE);
-            pieces_[mailbox(i,j,2)] = Piece(NIL, WHITE);
-            pieces_[mailbox(i,j,3)] = Piece(NIL, WHITE);
-            pieces_[mailbox(i,j,4)] = Piece(NIL, WHITE);
-            pieces_[mailbox(i,j,5)] = Piece(NIL, WHITE);
-            pieces_[mailbox(i,j,6)] = Piece(B_PAWN, BLACK);
-            pieces_[mailbox(i,j,7)] = Piece(pt, BLACK);
+            addPiece(Piece(pt, WHITE), squareAt(i,j,0));
+            addPiece(Piece(W_PAWN, WHITE), squareAt(i,j,1));
+            addPiece(Piece(B_PAWN, BLACK), squareAt(i,j,6));
+            addPiece(Piece(pt, BLACK), squareAt(i,j,7));
+        }
+    }
+
+    first_turn_ = WHITE;
+    resetStates();
+}
+
+bool Board::setPosition(const string& position)
+{
+    std::istringstream in (position);
+    string layout, side, castling, ep;
+    if(!(in >> layout >> side >> castling >> ep))
+        return false;
+
+    // Read the pieces into a scratch array, so that a bad position leaves the
+    // board as it was
+    Piece placed [NUM_SQUARES];
+    int counts [2] = {0, 0};
+    int x = 0, y = 0, z = 0;
+
+    for(size_t i = 0; i < layout.size(); i++)
+    {
+        char c = layout[i];
+        if(c == '/' || c == '|')
+        {
+            // Rows have to be complete, and so do levels
+            if(x != 8 || (c == '|' && y != 7))
+                return false;
+
+            x = 0;
+            if(c == '/')
+                y++;
+            else
+            {
+                y = 0;
+                z++;
+            }
         }
+        else if(c >= '1' && c <= '8')
+            x += c - '0';
+        else
+        {
+            Piece p = parsePieceLetter(c);
+            if(p.type() == NIL || x > 7 || ++counts[p.color()] > MAX_PIECES)
+                return false;
+            placed[squareAt(x, y, z)] = p;
+            x++;
+        }
+
+        if(x > 8 || y > 7 || z > 7)
+            return false;
+    }
+
+    if(x != 8 || y != 7 || z != 7)
+        return false;
+
+    if(side != "w" && side != "b")
+        return false;
+
+    unsigned long rights = 0;
+    if(castling != "-")
+    {
+        char* end;
+        rights = strtoul(castling.c_str(), &end, 16);
+        if(*end != '\0' || rights > ALL_CASTLING_RIGHTS)
+            return false;
+    }
+
+    int ep_square = NO_EP_SQUARE;
+    if(ep != "-" && (ep_square = parseSquare(ep)) == -1)
+        return false;
+
+    // Everything checks out, so set up the board
+    for(int i = 0; i < NUM_SQUARES; i++)
+        pieces_[i] = Piece(NIL, WHITE);
+
+    clearPieceLists();
+
+    for(int i = 0; i < NUM_SQUARES; i++)
+        if(placed[i].type() != NIL)
+            addPiece(placed[i], i);
+
+    first_turn_ = (side == "w") ? WHITE : BLACK;
+    resetStates();
+
+    states_.back().castling_rights = rights;
+    states_.back().ep_square = ep_square;
+    hash_ = computeHash();
+    states_.back().hash = hash_;
+
+    return true;
+}
+
+string Board::getPosition() const
+{
+    string layout;
+    for(int z = 0; z < 8; z++)
+    {
+        for(int y = 0; y < 8; y++)
+        {
+            int empty = 0;
+            for(int x = 0; x < 8; x++)
+            {
+                Piece p = pieces_[squareAt(x, y, z)];
+                if(p.type() == NIL)
+                {
+                    empty++;
+                    continue;
+                }
+
+                if(empty > 0)
+                    layout += (char) ('0' + empty);
+                layout += pieceLetter(p);
+                empty = 0;
+            }
+
+            if(empty > 0)
+                layout += (char) ('0' + empty);
+            if(y < 7)
+                layout += '/';
+        }
+
+        if(z < 7)
+            layout += '|';
     }
 
-    history_ = stack<Move>();
-    ep_locations_ = stack<int>();
-    castling_rights_ = stack<unsigned short>();
-    captured_ = stack<Piece>();
+    const StateInfo& state = states_.back();
+    std::ostringstream out;
+    out << layout << ' ' << (whoseTurn() == WHITE ? 'w' : 'b') << ' ';
+
+    if(state.castling_rights == 0)
+        out << '-';
+    else
+        out << std::hex << state.castling_rights << std::dec;
+
+    out << ' ';
+    if(state.ep_square == NO_EP_SQUARE)
+        out << '-';
+    else
+        out << squareName(state.ep_square);
 
-    ep_locations_.push(NO_EP_SQUARE);
-    castling_rights_.push(0x0FFF);
+    return out.str();
 }
 
 Piece Board::getPiece(int i) const
@@ -195,87 +363,384 @@ Piece Board::getPiece(int i) const
 Piece Board::putPiece(const Piece& p, int i)
 {
     Piece q = pieces_[i];
-    pieces_[i] = p;
+
+    // A side can't have more pieces than its lists hold, so a piece that
+    // would be one too many isn't placed
+    if(isPiece(p) && num_pieces_[p.color()] >= MAX_PIECES &&
+       !(isPiece(q) && q.color() == p.color()))
+        return p;
+
+    if(isPiece(q))
+        removePiece(i);
+
+    if(isPiece(p))
+        addPiece(p, i);
+    else
+        pieces_[i] = p;
+
+    // The position changed without a move, so the state has to follow
+    states_.back().hash = hash_;
+    states_.back().game_state = UNKNOWN_STATE;
+
     return q;
 }
 
-// TODO this is very slow, and it's called in many places. Consider re-writing
-// or cacheing the result
-bool Board::isInCheck(bool color) const
+uint64_t Board::hash() const
+{
+    return hash_;
+}
+
+uint64_t Board::pawnHash() const
+{
+    return pawn_hash_;
+}
+
+const Score& Board::psqScore() const
+{
+    return psq_;
+}
+
+int Board::phase() const
+{
+    return phase_;
+}
+
+const Accumulator& Board::accumulator() const
 {
-    list<Move> opponents_moves = generatePseudoLegalMoves(!color);
-    list<Move>::const_iterator it;
-    for(it = opponents_moves.begin(); it != opponents_moves.end(); it++)
+    const Network* net = activeNetwork();
+    if(accumulator_.network != net)
     {
-        if(it->type() == CAPTURE || it->type() == PROMO_CAPTURE)
+        accumulator_.network = net;
+        accumulator_.dirty[WHITE] = true;
+        accumulator_.dirty[BLACK] = true;
+    }
+
+    if(net == NULL)
+        return accumulator_;
+
+    for(int side = 0; side < 2; side++)
+    {
+        if(!accumulator_.dirty[side])
+            continue;
+
+        int16_t* values = accumulator_.values[side];
+        std::copy(net->feature_biases, net->feature_biases + NNUE_HIDDEN,
+                  values);
+        for(int color = 0; color < 2; color++)
         {
-            Piece captured = pieces_[it->target()];
-            if(captured.type() == KING)
-                return true;
+            for(int n = 0; n < num_pieces_[color]; n++)
+            {
+                int sq = piece_squares_[color][n];
+                addFeature(*net, values, Network::feature(side, pieces_[sq],
+                        sq, king_squares_[side]));
+            }
         }
+        accumulator_.dirty[side] = false;
     }
 
-    return false;
+    return accumulator_;
 }
 
-GameState Board::getGameState() const
+int Board::countPieces(bool color) const
+{
+    return num_pieces_[color];
+}
+
+int Board::countPieces(bool color, PieceType pt) const
 {
-    if(isInSomemate(WHITE))
-        return isInCheck(WHITE) ? CHECKMATE_WHITE : STALEMATE_WHITE;
+    return pieces(color, pt).count();
+}
+
+Bitboard Board::pieces(bool color) const
+{
+    return by_color_[color];
+}
+
+Bitboard Board::pieces(bool color, PieceType pt) const
+{
+    return by_color_[color] & by_type_[pt];
+}
 
-    if(isInSomemate(BLACK))
-        return isInCheck(BLACK) ? CHECKMATE_BLACK : STALEMATE_BLACK;
+Bitboard Board::occupied() const
+{
+    return by_color_[WHITE] | by_color_[BLACK];
+}
+
+int Board::getPieceSquare(bool color, int n) const
+{
+    return piece_squares_[color][n];
+}
+
+bool Board::isInCheck(bool color) const
+{
+    int king_sq = king_squares_[color];
+    if(king_sq == NO_SQUARE)
+        return false;
 
-    return IN_PROGRESS;
+    return isSquareAttacked(king_sq, !color);
 }
 
-const stack<Move>& Board::getHistory() const
+bool Board::isSquareAttacked(int square, bool color) const
 {
-    return history_;
+    return isAttackedAfter(square, color, NO_SQUARE, NO_SQUARE, NO_SQUARE);
 }
 
-list<Move> Board::generatePseudoLegalMoves(int color) const
+int Board::staticExchange(const Move& m) const
 {
-    list<Move> moves;
-    list<Move> temp;
+    int target = m.target();
+    MoveType type = m.type();
+    int forward = (m.color() == WHITE) ? 64 : -64;
+
+    // What the move itself takes, and what it leaves on the target to lose
+    int captured = 0;
+    if(type == CAPTURE || type == PROMO_CAPTURE)
+        captured = PIECE_VALUES[pieces_[target].type()];
+    else if(type == EN_PASSANT)
+        captured = PIECE_VALUES[W_PAWN];
+
+    int on_target = PIECE_VALUES[pieces_[m.origin()].type()];
+    if(type == PROMOTE || type == PROMO_CAPTURE)
+    {
+        captured += PIECE_VALUES[m.promoted()] - PIECE_VALUES[W_PAWN];
+        on_target = PIECE_VALUES[m.promoted()];
+    }
+
+    Bitboard occupied = this->occupied();
+    occupied.clear(m.origin());
+    if(type == EN_PASSANT)
+        occupied.clear(target - forward);
+    Bitboard attackers = attackersTo(target, occupied);
 
-    for(int i = 0; i < 1728; i++)
+    // gain[n] is what the side making the nth capture has won, if the other
+    // side doesn't take back. Each capture can only take one piece off the
+    // board, so there can't be more of them than there are pieces.
+    int gain [2 * MAX_PIECES + 1];
+    gain[0] = captured;
+    int n = 0;
+
+    for(bool color = !m.color(); ; color = !color)
     {
-        if(pieces_[i].isOn(color))
+        Bitboard ours = attackers & by_color_[color];
+        if(ours.empty())
+            break;
+
+        // The king only takes if nothing is left to take it back
+        int from = NO_SQUARE;
+        int value = 0;
+        for(int pt = W_PAWN; pt < KING; pt++)
         {
-            temp = generateMoves(i);
-            moves.splice(moves.end(), temp);
+            Bitboard candidates = ours & by_type_[pt];
+            if(!candidates.empty() &&
+               (from == NO_SQUARE || PIECE_VALUES[pt] < value))
+            {
+                from = candidates.lowest();
+                value = PIECE_VALUES[pt];
+            }
         }
+        if(from == NO_SQUARE)
+            from = (ours & by_type_[KING]).lowest();
+
+        // Taking the capturer off the board may uncover a slider behind it
+        occupied.clear(from);
+        attackers = attackersTo(target, occupied);
+        if(pieces_[from].type() == KING &&
+           !(attackers & by_color_[!color]).empty())
+            break;
+
+        n++;
+        gain[n] = on_target - gain[n - 1];
+        on_target = value;
     }
 
-    // TODO should I wrap this into generateMoves for a king?
-    temp = generateCastlingMoves(color);
-    moves.splice(moves.end(), temp);
+    // Either side can stop taking whenever that's better for it
+    for(; n > 0; n--)
+        gain[n - 1] = -std::max(-gain[n - 1], gain[n]);
+
+    return gain[0];
+}
+
+bool Board::whoseTurn() const
+{
+    // Every move flips the side to move
+    bool moved = (states_.size() % 2 == 0);
+    return first_turn_ ^ moved;
+}
+
+GameState Board::getGameState() const
+{
+    // Only the side to move can be out of moves, and the answer can't change
+    // until the position does
+    const StateInfo& state = states_.back();
+    if(state.game_state != UNKNOWN_STATE)
+        return static_cast<GameState>(state.game_state);
+
+    bool color = whoseTurn();
+    GameState game_state = IN_PROGRESS;
+
+    if(!hasLegalMove(color))
+    {
+        if(color == WHITE)
+            game_state = isInCheck(WHITE) ? CHECKMATE_WHITE : STALEMATE_WHITE;
+        else
+            game_state = isInCheck(BLACK) ? CHECKMATE_BLACK : STALEMATE_BLACK;
+    }
+
+    state.game_state = game_state;
+    return game_state;
+}
+
+bool Board::hasLegalMove(bool color) const
+{
+    int king_sq = king_squares_[color];
 
-    return moves;
+    // King steps are the cheapest to check, and the likeliest way out of
+    // check
+    if(king_sq != NO_SQUARE)
+    {
+        Bitboard steps = Geometry::leaps(KING, king_sq) & ~by_color_[color];
+        while(!steps.empty())
+        {
+            int target = steps.popLowest();
+            if(!isAttackedAfter(target, !color, king_sq, target, NO_SQUARE))
+                return true;
+        }
+    }
+
+    MoveList moves;
+    generatePseudoLegalMoves(color, moves);
+
+    // Then captures, since they can take the checker, and then everything
+    // else. The king's steps have all been tried already.
+    for(int pass = 0; pass < 2; pass++)
+    {
+        for(const Move* it = moves.begin(); it != moves.end(); it++)
+        {
+            if(it->origin() == king_sq && it->type() != CASTLE)
+                continue;
+
+            if(it->isCapture() != (pass == 0))
+                continue;
+
+            if(isLegalMove(*it))
+                return true;
+        }
+    }
+
+    return false;
+}
+
+vector<Move> Board::getHistory() const
+{
+    vector<Move> history;
+    for(size_t i = 1; i < states_.size(); i++)
+        history.push_back(states_[i].move);
+    return history;
+}
+
+void Board::generatePseudoLegalMoves(int color, MoveList& moves) const
+{
+    if(color == WHITE)
+        generateAllMoves<WHITE, ALL_MOVES>(moves);
+    else
+        generateAllMoves<BLACK, ALL_MOVES>(moves);
 }
 
-list<Move> Board::generateMoves(int origin) const
+void Board::generateCaptures(bool color, MoveList& moves) const
 {
-    PieceType pt = pieces_[origin].type();
+    if(color == WHITE)
+        generateAllMoves<WHITE, CAPTURES>(moves);
+    else
+        generateAllMoves<BLACK, CAPTURES>(moves);
+}
+
+void Board::generatePromotions(bool color, MoveList& moves) const
+{
+    if(color == WHITE)
+        generateAllMoves<WHITE, PROMOTIONS>(moves);
+    else
+        generateAllMoves<BLACK, PROMOTIONS>(moves);
+}
 
-    if(pt == NIL || pt == BORDER)
-        return list<Move>(0);
-    else if(pt == W_PAWN || pt == B_PAWN)
-        return generatePawnMoves(origin);
+void Board::generateQuiets(bool color, MoveList& moves) const
+{
+    if(color == WHITE)
+        generateAllMoves<WHITE, QUIETS>(moves);
     else
-        return generateNonPawnMoves(origin);
+        generateAllMoves<BLACK, QUIETS>(moves);
 }
 
-// Note: This cannot be modified to only get legal castles, because that would
-// require calling "isInCheck", which calls "generatePseudoLegalMoves", which
-// calls this method, ...
-list<Move> Board::generateCastlingMoves(bool color) const
+void Board::generateMoves(int origin, MoveList& moves) const
 {
-    list<Move> moves;
+    Piece p = pieces_[origin];
+    bool color = p.color();
+    Bitboard occupied = this->occupied();
+
+    switch(p.type())
+    {
+      case W_PAWN:
+      case B_PAWN:
+        if(color == WHITE)
+        {
+            generatePawnPushes<WHITE>(Bitboard::square(origin), moves);
+            generatePawnCaptures<WHITE>(origin, moves);
+        }
+        else
+        {
+            generatePawnPushes<BLACK>(Bitboard::square(origin), moves);
+            generatePawnCaptures<BLACK>(origin, moves);
+        }
+        break;
+      case KNIGHT:
+        generatePieceMoves<KNIGHT>(origin, color, occupied, moves);
+        break;
+      case GRIFFIN:
+        generatePieceMoves<GRIFFIN>(origin, color, occupied, moves);
+        break;
+      case DRAGON:
+        generatePieceMoves<DRAGON>(origin, color, occupied, moves);
+        break;
+      case UNICORN:
+        generatePieceMoves<UNICORN>(origin, color, occupied, moves);
+        break;
+      case ROOK:
+        generatePieceMoves<ROOK>(origin, color, occupied, moves);
+        break;
+      case BISHOP:
+        generatePieceMoves<BISHOP>(origin, color, occupied, moves);
+        break;
+      case MACE:
+        generatePieceMoves<MACE>(origin, color, occupied, moves);
+        break;
+      case WIZARD:
+        generatePieceMoves<WIZARD>(origin, color, occupied, moves);
+        break;
+      case ARCHER:
+        generatePieceMoves<ARCHER>(origin, color, occupied, moves);
+        break;
+      case CANNON:
+        generatePieceMoves<CANNON>(origin, color, occupied, moves);
+        break;
+      case QUEEN:
+        generatePieceMoves<QUEEN>(origin, color, occupied, moves);
+        break;
+      case KING:
+        generatePieceMoves<KING>(origin, color, occupied, moves);
+        break;
+      default:
+        break;
+    }
+}
 
+// Note: Legality (not castling out of, through, or into check) is left to
+// isLegalMove, so that this matches the other pseudo-legal generators.
+void Board::generateCastlingMoves(bool color, MoveList& moves) const
+{
     int king_sq = kingSquare(color);
 
+    // Positions built with putPiece can have rights without the king
+    if(pieces_[king_sq] != Piece(KING, color))
+        return;
+
     for(int axis = 0; axis < 6; axis++)
     {
         // Get the direction of travel
@@ -283,7 +748,7 @@ list<Move> Board::generateCastlingMoves(bool color) const
 
         // Yes, that is a goto. Yes, I know it's frowned upon. But for this
         // particular circumstance, it's the cleanest tool for the job.
-        if(castling_rights_.top() & castleMask(color, axis))
+        if(states_.back().castling_rights & castleMask(color, axis))
         {
             // Check if the path is clear
             for(int dist = 1; dist < castleDist(axis); dist++)
@@ -298,41 +763,76 @@ list<Move> Board::generateCastlingMoves(bool color) const
         failed:
             ; // empty statement
     }
+}
+
+bool Board::isPseudoLegalMove(const Move& m) const
+{
+    // A move from somewhere else might not even have the right piece on its
+    // origin. If it does, it's enough to see if that piece could make it.
+    if(!pieces_[m.origin()].isOn(m.color()))
+        return false;
+
+    MoveList moves;
+    if(m.type() == CASTLE)
+        generateCastlingMoves(m.color(), moves);
+    else
+        generateMoves(m.origin(), moves);
 
-    return moves;
+    return moves.contains(m);
 }
 
-// TODO make non-const version that uses undo
 bool Board::isLegalMove(const Move& m) const
 {
-    Board copy (*this);
+    bool color = m.color();
 
     if(m.type() == CASTLE)
     {
         // Note: we don't need to move the rook/wizard to determine
-        // intermediate check. Only the king.
+        // intermediate check. Only the king. And since the path is clear, the
+        // king can't block an attack on the later squares by standing on the
+        // earlier ones.
         int dir = (m.target() - m.origin()) / 2;
         int middle = m.origin() + dir;
 
-        // If any king is in check, then we cannot castle
-        Piece king = copy.pieces_[m.origin()];
-        copy.pieces_[m.target()] = king;
-        copy.pieces_[middle] = king;
-        return !copy.isInCheck(m.color());
-    }
-    else
-    {
-        copy.makeMove(m);
-        return !copy.isInCheck(m.color());
+        // If any of the king's squares are attacked, then we cannot castle
+        return !isSquareAttacked(m.origin(), !color) &&
+               !isSquareAttacked(middle, !color) &&
+               !isSquareAttacked(m.target(), !color);
     }
+
+    // Only the en passant capture takes a piece off a square other than the
+    // target. (Promotions don't matter, since our pieces don't attack us.)
+    int removed = NO_SQUARE;
+    if(m.type() == EN_PASSANT)
+        removed = m.target() - ((color == WHITE) ? 64 : -64);
+
+    // If the king is moving, it's the target we need to check
+    int king_sq = king_squares_[color];
+    if(king_sq == m.origin())
+        king_sq = m.target();
+    else if(king_sq == NO_SQUARE)
+        return true;
+
+    return !isAttackedAfter(king_sq, !color, m.origin(), m.target(), removed);
 }
 
 void Board::makeMove(const Move& m)
 {
+    assert(m != Move());
+
+    const StateInfo& prev = states_.back();
+
+    StateInfo next;
+    next.move = m;
+    next.captured = Piece(NIL, WHITE);
+    next.ep_square = NO_EP_SQUARE; // Modified in DPP only
+    next.castling_rights = updateCastlingRights(prev.castling_rights,
+            m.color(), m.origin());
+    next.game_state = UNKNOWN_STATE;
+
     MoveType type = m.type();
-    int forward = (m.color() == WHITE) ? 144 : -144;
+    int forward = (m.color() == WHITE) ? 64 : -64;
 
-    int next_ep = NO_EP_SQUARE;  // Modified in DPP only
     int dir, dist, rook_sq; // Used for castling only
 
     switch(type)
@@ -340,13 +840,14 @@ void Board::makeMove(const Move& m)
       case QUIET:
         break;
       case DOUBLE_PAWN_PUSH:
-        next_ep = m.origin() + forward;
+        next.ep_square = m.origin() + forward;
         break;
       case CAPTURE:
-        captured_.push(pieces_[m.target()]);
+        next.captured = pieces_[m.target()];
+        removePiece(m.target());
         break;
       case EN_PASSANT:
-        pieces_[m.target() - forward] = Piece(NIL, WHITE);
+        removePiece(m.target() - forward);
         break;
       case CASTLE:
         // The king moves two squares, so we can find the direction by halving,
@@ -355,54 +856,54 @@ void Board::makeMove(const Move& m)
         dist = (dir > 0) ? 3 : 4;
         // and the rook square by combining those.
         rook_sq = m.origin() + dir * dist;
-        // Move the rook
-        pieces_[m.origin() + dir] = pieces_[rook_sq];
-        pieces_[rook_sq] = Piece(NIL, WHITE);
+        // Move the rook, if it's still there
+        if(pieces_[rook_sq].type() != NIL)
+            movePiece(rook_sq, m.origin() + dir);
         break;
       case PROMOTE:
-        pieces_[m.origin()] = Piece(m.promoted(), m.color());
+        removePiece(m.origin());
+        addPiece(Piece(m.promoted(), m.color()), m.origin());
         break;
       case PROMO_CAPTURE:
-        pieces_[m.origin()] = Piece(m.promoted(), m.color());
-        captured_.push(pieces_[m.target()]);
+        removePiece(m.origin());
+        addPiece(Piece(m.promoted(), m.color()), m.origin());
+        next.captured = pieces_[m.target()];
+        removePiece(m.target());
         break;
     }
 
     // Moves piece from origin to target, and clears the origin
-    pieces_[m.target()] = pieces_[m.origin()];
-    pieces_[m.origin()] = Piece(NIL, WHITE);
+    movePiece(m.origin(), m.target());
 
-    // Push the next en passant location
-    ep_locations_.push(next_ep);
+    // The pieces were hashed as they moved; now hash everything else
+    hash_ ^= enPassantKey(prev.ep_square) ^ enPassantKey(next.ep_square);
+    hash_ ^= Zobrist::castling(prev.castling_rights ^ next.castling_rights);
+    hash_ ^= Zobrist::side();
+    next.hash = hash_;
 
-    // Maybe we moved the king or rooks/wizards?
-    updateCastlingRights(m.color(), m.origin());
+    // Records the new state. Note that this may invalidate prev.
+    states_.push_back(next);
 
-    // Records move
-    history_.push(m);
+    assert(hash_ == computeHash());
+    assert(pawn_hash_ == computePawnHash());
+    assert(psq_ == computePsqScore());
 }
 
 void Board::undoMove()
 {
-    if(history_.empty())
+    if(states_.size() == 1)
         return;
 
-    // Recalls the most recent move
-    Move m = history_.top();
-    history_.pop();
-
-    // Recalls the previous castling rights
-    castling_rights_.pop();
-
-    // Recalls the previous en passant square, if any
-    ep_locations_.pop();
+    // Recalls the most recent move, and returns to the state before it
+    StateInfo last = states_.back();
+    states_.pop_back();
+    Move m = last.move;
 
     // Moves piece from target to origin, and clears the target
-    pieces_[m.origin()] = pieces_[m.target()];
-    pieces_[m.target()] = Piece(NIL, WHITE);
+    movePiece(m.target(), m.origin());
 
     MoveType type = m.type();
-    int forward = (m.color() == WHITE) ? 144 : -144;
+    int forward = (m.color() == WHITE) ? 64 : -64;
 
     int dir, dist, rook_sq; // Used for castling only
 
@@ -412,11 +913,10 @@ void Board::undoMove()
       case DOUBLE_PAWN_PUSH:
         break;
       case CAPTURE:
-        pieces_[m.target()] = captured_.top();
-        captured_.pop();
+        addPiece(last.captured, m.target());
         break;
       case EN_PASSANT:
-        pieces_[m.target() - forward] = Piece::Pawn(!m.color());
+        addPiece(Piece::Pawn(!m.color()), m.target() - forward);
         break;
       case CASTLE:
         // The king moves two squares, so we can find the direction by halving,
@@ -425,166 +925,655 @@ void Board::undoMove()
         dist = (dir > 0) ? 3 : 4;
         // and the rook square by combining those.
         rook_sq = m.origin() + dir * dist;
-        // Move the rook back
-        pieces_[rook_sq] = pieces_[m.origin() + dir];
-        pieces_[m.origin() + dir] = Piece(NIL, WHITE);
+        // Move the rook back, if there was one
+        if(pieces_[m.origin() + dir].type() != NIL)
+            movePiece(m.origin() + dir, rook_sq);
         break;
       case PROMOTE:
-        pieces_[m.origin()] = Piece::Pawn(m.color());
+        removePiece(m.origin());
+        addPiece(Piece::Pawn(m.color()), m.origin());
         break;
       case PROMO_CAPTURE:
-        pieces_[m.origin()] = Piece::Pawn(m.color());
-        pieces_[m.target()] = captured_.top();
-        captured_.pop();
+        removePiece(m.origin());
+        addPiece(Piece::Pawn(m.color()), m.origin());
+        addPiece(last.captured, m.target());
         break;
     }
+
+    // The previous state remembers its own hash
+    hash_ = states_.back().hash;
+
+    assert(hash_ == computeHash());
+    assert(pawn_hash_ == computePawnHash());
+    assert(psq_ == computePsqScore());
 }
 
-//----PRIVATE----
+void Board::makeNullMove()
+{
+    const StateInfo& prev = states_.back();
+
+    StateInfo next;
+    next.move = Move();
+    next.captured = Piece(NIL, WHITE);
+    next.ep_square = NO_EP_SQUARE;
+    next.castling_rights = prev.castling_rights;
+    next.game_state = UNKNOWN_STATE;
+
+    hash_ ^= enPassantKey(prev.ep_square) ^ Zobrist::side();
+    next.hash = hash_;
+
+    // Note that this may invalidate prev
+    states_.push_back(next);
+
+    assert(hash_ == computeHash());
+}
 
-list<Move> Board::generatePawnMoves(int origin) const
+void Board::undoNullMove()
 {
-    list<Move> moves;
-    Piece p = pieces_[origin];
-    bool color = p.color();
+    assert(states_.size() > 1 && states_.back().move == Move());
 
-    int forward = (color == WHITE) ? 144 : -144;
-    int ahead = origin + forward;
-    int twoAhead = ahead + forward;
+    states_.pop_back();
+    hash_ = states_.back().hash;
+}
 
-    int rank = (origin / 144) - 2;
-    int homeRank = (color == WHITE) ? 1 : 6;
-    int promoRank = 7 - homeRank;
+void Board::generateLegalMoves(bool color, MoveList& moves) const
+{
+    int king_sq = king_squares_[color];
 
-    // Can we move forward?
-    if(pieces_[ahead].type() == NIL)
+    // Without a king, nothing can be illegal
+    if(king_sq == NO_SQUARE)
     {
-        // Are we currently on the second-to-last rank?
-        if(rank == promoRank)
+        generatePseudoLegalMoves(color, moves);
+        return;
+    }
+
+    // Marks the pin and check rays. Squares not on one are left as 0.
+    unsigned char rays [NUM_SQUARES];
+    memset(rays, 0, sizeof(rays));
+    int num_checkers = 0;
+
+    Bitboard occupied = this->occupied();
+    Bitboard enemies = by_color_[!color];
+
+    // Look out from the king along all 26 lines. An enemy slider on the line
+    // is giving check; an enemy slider behind one of our pieces pins it.
+    for(int dir = 0; dir < NUM_LINES; dir++)
+    {
+        Bitboard sliders = slidersAlong(!color, lineOfDirection(dir));
+
+        int first = Geometry::firstBlocker(king_sq, dir, occupied);
+        if(first == OFF_BOARD)
+            continue;
+
+        if(enemies.test(first))
         {
-            // Iterate through all possible promotions
-            for(int i = 0; i < NUM_PROMOTION_PIECES; i++)
+            if(sliders.test(first))
             {
-                PieceType pt = PROMOTION_PIECES[i];
-                moves.push_back(Move(color, PROMOTE, origin, ahead, pt));
+                num_checkers++;
+                Bitboard line = Geometry::ray(king_sq, dir) ^
+                                Geometry::ray(first, dir);
+                while(!line.empty())
+                    rays[line.popLowest()] |= CHECK_RAY;
             }
         }
         else
-            moves.push_back(Move(color, QUIET, origin, ahead));
+        {
+            int second = Geometry::firstBlocker(first, dir, occupied);
+            if(second != OFF_BOARD && sliders.test(second))
+            {
+                Bitboard line = Geometry::ray(king_sq, dir) ^
+                                Geometry::ray(second, dir);
+                while(!line.empty())
+                    rays[line.popLowest()] |= (dir + 1);
+            }
+        }
+    }
 
-        // Can we perform a double pawn push?
-        if(rank == homeRank && pieces_[twoAhead].type() == NIL)
-            moves.push_back(Move(color, DOUBLE_PAWN_PUSH, origin, twoAhead));
+    // Pawn, leaper and king checks can only be stopped by capturing the
+    // checker
+    Bitboard checkers = leaperAttackers(king_sq, !color, enemies);
+    while(!checkers.empty())
+    {
+        num_checkers++;
+        rays[checkers.popLowest()] |= CHECK_RAY;
     }
 
-    // Can we capture things?
-    for(int i = 0; i < NUM_DIRECTIONS[p.type()]; i++)
+    // Now generate everything, and keep only the legal moves
+    int start = moves.size();
+    generatePseudoLegalMoves(color, moves);
+
+    int end = start;
+    for(int n = start; n < moves.size(); n++)
     {
-        int target = origin + PIECE_DIRECTIONS[p.type()][i];
-        Piece target_piece = pieces_[target];
+        Move m = moves[n];
+        bool legal;
 
-        // Is this an enemy piece?
-        if(p.isEnemy(target_piece))
+        if(m.type() == CASTLE)
         {
-            // Are we currently on the second-to-last rank?
-            if(rank == promoRank)
-            {
-                // Iterate through all possible promotions
-                for(int i = 0; i < NUM_PROMOTION_PIECES; i++)
-                {
-                    PieceType pt = PROMOTION_PIECES[i];
-                    Move m (color, PROMO_CAPTURE, origin, target, pt);
-                    moves.push_back(m);
-                }
-            }
-            else
-                moves.push_back(Move(color, CAPTURE, origin, target));
+            int middle = m.origin() + (m.target() - m.origin()) / 2;
+            legal = (num_checkers == 0) &&
+                    !isSquareAttacked(middle, !color) &&
+                    !isSquareAttacked(m.target(), !color);
+        }
+        else if(m.origin() == king_sq)
+        {
+            // The king mustn't block an attack on its destination
+            legal = !isAttackedAfter(m.target(), !color, king_sq, m.target(),
+                    NO_SQUARE);
+        }
+        else if(num_checkers > 1)
+        {
+            // Double check; only the king can move
+            legal = false;
+        }
+        else if(m.type() == EN_PASSANT)
+        {
+            // Two pieces leave the same line, so the rays aren't enough
+            int forward = (color == WHITE) ? 64 : -64;
+            legal = !isAttackedAfter(king_sq, !color, m.origin(), m.target(),
+                    m.target() - forward);
         }
+        else
+        {
+            // Pinned pieces have to stay on their ray, and if we're in check,
+            // we have to capture or block the checker
+            int pin = rays[m.origin()] & PIN_RAY;
+            legal = (pin == 0 || (rays[m.target()] & PIN_RAY) == pin) &&
+                    (num_checkers == 0 || (rays[m.target()] & CHECK_RAY));
+        }
+
+        if(legal)
+            moves[end++] = m;
+    }
+
+    moves.resize(end);
+}
 
-        // Can we perform en passant?
-        if(ep_locations_.top() == target)
-            moves.push_back(Move(color, EN_PASSANT, origin, target));
+//----PRIVATE----
+
+bool Board::isAttackedAfter(int square, bool color, int from, int to,
+        int removed) const
+{
+    // Work out the occupancy after the move. The moving piece is never one of
+    // the attackers, but it may have captured one.
+    Bitboard occupied = this->occupied();
+    Bitboard attackers = by_color_[color];
+
+    if(from != NO_SQUARE)
+        occupied.clear(from);
+    if(removed != NO_SQUARE)
+    {
+        occupied.clear(removed);
+        attackers.clear(removed);
+    }
+    if(to != NO_SQUARE)
+    {
+        occupied.set(to);
+        attackers.clear(to);
+    }
 
+    if(!leaperAttackers(square, color, attackers).empty())
+        return true;
+
+    // Look out along all 26 lines. The first piece on each is the only one
+    // that can attack along it.
+    for(int dir = 0; dir < NUM_LINES; dir++)
+    {
+        int line = lineOfDirection(dir);
+        Bitboard sliders = slidersAlong(color, line) & attackers;
+        if(sliders.empty())
+            continue;
+
+        int first = Geometry::firstBlocker(square, dir, occupied);
+        if(first != OFF_BOARD && sliders.test(first))
+            return true;
     }
 
-    return moves;
+    return false;
 }
 
-list<Move> Board::generateNonPawnMoves(int origin) const
+Bitboard Board::leaperAttackers(int square, bool color,
+        const Bitboard& attackers) const
+{
+    // The leapers' offsets are symmetric, so a knight (say) attacks this
+    // square iff a knight could move from this square onto it. The unicorn
+    // moves as all three of them. Pawns attack "forward", so we look from
+    // the square as if we were a pawn of the other color.
+    PieceType pawn = Piece::Pawn(color).type();
+    PieceType other_pawn = Piece::Pawn(!color).type();
+
+    Bitboard found;
+    found |= Geometry::leaps(other_pawn, square) & by_type_[pawn];
+    found |= Geometry::leaps(KNIGHT, square) &
+             (by_type_[KNIGHT] | by_type_[UNICORN]);
+    found |= Geometry::leaps(GRIFFIN, square) &
+             (by_type_[GRIFFIN] | by_type_[UNICORN]);
+    found |= Geometry::leaps(DRAGON, square) &
+             (by_type_[DRAGON] | by_type_[UNICORN]);
+    found |= Geometry::leaps(KING, square) & by_type_[KING];
+
+    return found & attackers;
+}
+
+Bitboard Board::slidersAlong(bool color, int line) const
+{
+    Bitboard sliders;
+    for(int pt = ROOK; pt <= QUEEN; pt++)
+        if(SLIDER_LINES[pt] & line)
+            sliders |= by_type_[pt];
+
+    return sliders & by_color_[color];
+}
+
+Bitboard Board::attackersTo(int square, const Bitboard& occupied) const
+{
+    Bitboard found = leaperAttackers(square, WHITE, by_color_[WHITE]) |
+                     leaperAttackers(square, BLACK, by_color_[BLACK]);
+
+    // The sliders of both colors, for each family of lines
+    Bitboard sliders [3];
+    for(int n = 0; n < 3; n++)
+        sliders[n] = slidersAlong(WHITE, 1 << n) | slidersAlong(BLACK, 1 << n);
+
+    for(int dir = 0; dir < NUM_LINES; dir++)
+    {
+        const Bitboard& along = sliders[lineOfDirection(dir) >> 1];
+        if(along.empty())
+            continue;
+
+        int first = Geometry::firstBlocker(square, dir, occupied);
+        if(first != OFF_BOARD && along.test(first))
+            found.set(first);
+    }
+
+    return found & occupied;
+}
+
+void Board::addPiece(const Piece& p, int i)
 {
-    list<Move> moves;
-    Piece p = pieces_[origin];
-    PieceType type = p.type();
     bool color = p.color();
+    int n = num_pieces_[color]++;
+    assert(n < MAX_PIECES);
+
+    pieces_[i] = p;
+    piece_squares_[color][n] = i;
+    piece_indices_[i] = n;
+    by_color_[color].set(i);
+    by_type_[p.type()].set(i);
+    hash_ ^= Zobrist::piece(p, i);
+    if(isPawn(p))
+        pawn_hash_ ^= Zobrist::piece(p, i);
+    psq_ += PieceSquare::piece(p, i);
+    phase_ += PieceSquare::phase(p.type());
+
+    if(p.type() == KING)
+        king_squares_[color] = i;
+    accumulate(p, i, true);
+}
 
-    int num_dirs = NUM_DIRECTIONS[type];
+void Board::removePiece(int i)
+{
+    Piece p = pieces_[i];
+    bool color = p.color();
+    accumulate(p, i, false);
+
+    // Fills the hole with the last piece in the list
+    int n = piece_indices_[i];
+    int last = piece_squares_[color][--num_pieces_[color]];
+    piece_squares_[color][n] = last;
+    piece_indices_[last] = n;
+
+    pieces_[i] = Piece(NIL, WHITE);
+    by_color_[color].clear(i);
+    by_type_[p.type()].clear(i);
+    hash_ ^= Zobrist::piece(p, i);
+    if(isPawn(p))
+        pawn_hash_ ^= Zobrist::piece(p, i);
+    psq_ -= PieceSquare::piece(p, i);
+    phase_ -= PieceSquare::phase(p.type());
+
+    if(p.type() == KING && king_squares_[color] == i)
+        king_squares_[color] = NO_SQUARE;
+}
 
-    // Iterate through every permissible move direction
-    for(int i = 0; i < num_dirs; i++)
+void Board::movePiece(int from, int to)
+{
+    Piece p = pieces_[from];
+    int n = piece_indices_[from];
+
+    pieces_[to] = p;
+    pieces_[from] = Piece(NIL, WHITE);
+    piece_squares_[p.color()][n] = to;
+    piece_indices_[to] = n;
+
+    Bitboard change = Bitboard::square(from) | Bitboard::square(to);
+    by_color_[p.color()] ^= change;
+    by_type_[p.type()] ^= change;
+
+    hash_ ^= Zobrist::piece(p, from);
+    hash_ ^= Zobrist::piece(p, to);
+    if(isPawn(p))
+        pawn_hash_ ^= Zobrist::piece(p, from) ^ Zobrist::piece(p, to);
+    psq_ -= PieceSquare::piece(p, from);
+    psq_ += PieceSquare::piece(p, to);
+
+    // A king that stays in its bucket moves just its own feature
+    const Network* net = accumulator_.network;
+    for(int side = 0; net != NULL && side < 2; side++)
     {
-        int target = origin;
-        while(true) // this is so sliding pieces continue moving
+        if(accumulator_.dirty[side])
+            continue;
+
+        int king_sq = king_squares_[side];
+        if(p.type() == KING && p.color() == side &&
+           Network::kingBucket(side, from) != Network::kingBucket(side, to))
         {
-            target += PIECE_DIRECTIONS[type][i];
-            Piece target_piece = pieces_[target];
+            accumulator_.dirty[side] = true;
+            continue;
+        }
+
+        int16_t* values = accumulator_.values[side];
+        subtractFeature(*net, values,
+                        Network::feature(side, p, from, king_sq));
+        addFeature(*net, values, Network::feature(side, p, to, king_sq));
+    }
 
-            // Did we hit something?
-            if(target_piece.type() != NIL)
+    if(p.type() == KING)
+        king_squares_[p.color()] = to;
+}
+
+void Board::accumulate(const Piece& p, int i, bool add)
+{
+    const Network* net = accumulator_.network;
+    if(net == NULL)
+        return;
+
+    for(int side = 0; side < 2; side++)
+    {
+        if(accumulator_.dirty[side])
+            continue;
+
+        if(p.type() == KING && p.color() == side)
+        {
+            accumulator_.dirty[side] = true;
+            continue;
+        }
+
+        int feature = Network::feature(side, p, i, king_squares_[side]);
+        if(add)
+            addFeature(*net, accumulator_.values[side], feature);
+        else
+            subtractFeature(*net, accumulator_.values[side], feature);
+    }
+}
+
+template<bool COLOR, Board::GenType GT>
+void Board::generateAllMoves(MoveList& moves) const
+{
+    const PieceType PAWN = (COLOR == WHITE) ? W_PAWN : B_PAWN;
+    Bitboard occupied = this->occupied();
+
+    // Pushes don't depend on anything but the pawn's own file, so they're
+    // all done at once. Everything else goes piece by piece.
+    Bitboard pawns = pieces(COLOR, PAWN);
+    if(GT & (PROMOTIONS | QUIETS))
+        generatePawnPushes<COLOR, GT>(pawns, moves);
+    if(GT & CAPTURES)
+        while(!pawns.empty())
+            generatePawnCaptures<COLOR>(pawns.popLowest(), moves);
+
+    // Only pawns promote
+    if(GT == PROMOTIONS)
+        return;
+
+    generateTypeMoves<KNIGHT, GT>(COLOR, occupied, moves);
+    generateTypeMoves<GRIFFIN, GT>(COLOR, occupied, moves);
+    generateTypeMoves<DRAGON, GT>(COLOR, occupied, moves);
+    generateTypeMoves<UNICORN, GT>(COLOR, occupied, moves);
+    generateTypeMoves<ROOK, GT>(COLOR, occupied, moves);
+    generateTypeMoves<BISHOP, GT>(COLOR, occupied, moves);
+    generateTypeMoves<MACE, GT>(COLOR, occupied, moves);
+    generateTypeMoves<WIZARD, GT>(COLOR, occupied, moves);
+    generateTypeMoves<ARCHER, GT>(COLOR, occupied, moves);
+    generateTypeMoves<CANNON, GT>(COLOR, occupied, moves);
+    generateTypeMoves<QUEEN, GT>(COLOR, occupied, moves);
+    generateTypeMoves<KING, GT>(COLOR, occupied, moves);
+
+    // TODO should I wrap this into generateMoves for a king?
+    if(GT & QUIETS)
+        generateCastlingMoves(COLOR, moves);
+}
+
+template<PieceType PT, Board::GenType GT>
+void Board::generateTypeMoves(bool color, const Bitboard& occupied,
+        MoveList& moves) const
+{
+    Bitboard origins = pieces(color, PT);
+    while(!origins.empty())
+        generatePieceMoves<PT, GT>(origins.popLowest(), color, occupied,
+                moves);
+}
+
+template<PieceType PT, Board::GenType GT>
+void Board::generatePieceMoves(int origin, bool color,
+        const Bitboard& occupied, MoveList& moves) const
+{
+    // Everything we attack, except our own pieces, is a target
+    Bitboard targets = attacksFrom<PT>(origin, occupied);
+
+    if(GT & CAPTURES)
+    {
+        Bitboard captures = targets & by_color_[!color];
+        while(!captures.empty())
+            moves.push_back(Move(color, CAPTURE, origin, captures.popLowest()));
+    }
+
+    if(GT & QUIETS)
+    {
+        Bitboard quiets = targets & ~occupied;
+        while(!quiets.empty())
+            moves.push_back(Move(color, QUIET, origin, quiets.popLowest()));
+    }
+}
+
+template<bool COLOR, Board::GenType GT>
+void Board::generatePawnPushes(const Bitboard& pawns, MoveList& moves) const
+{
+    const int FORWARD = (COLOR == WHITE) ? 64 : -64;
+    const int HOME_RANK = (COLOR == WHITE) ? 1 : 6;
+    const int LAST_RANK = (COLOR == WHITE) ? 7 : 0;
+
+    // Moving a whole rank forward is a shift, and the pawns that would move
+    // off the board just fall off the end
+    Bitboard empty = ~occupied();
+    Bitboard ahead = forward<COLOR>(pawns) & empty;
+
+    Bitboard promotions = ahead & Bitboard::level(LAST_RANK);
+    ahead ^= promotions;
+
+    if(GT & QUIETS)
+    {
+        Bitboard twoAhead = forward<COLOR>(
+                forward<COLOR>(pawns & Bitboard::level(HOME_RANK)) & empty) &
+                empty;
+
+        while(!ahead.empty())
+        {
+            int target = ahead.popLowest();
+            moves.push_back(Move(COLOR, QUIET, target - FORWARD, target));
+        }
+
+        while(!twoAhead.empty())
+        {
+            int target = twoAhead.popLowest();
+            moves.push_back(Move(COLOR, DOUBLE_PAWN_PUSH, target - 2 * FORWARD,
+                    target));
+        }
+    }
+
+    if(GT & PROMOTIONS)
+    {
+        while(!promotions.empty())
+        {
+            int target = promotions.popLowest();
+            for(int i = 0; i < NUM_PROMOTION_PIECES; i++)
             {
-                // Was it an enemy piece?
-                if(p.isEnemy(target_piece))
-                    moves.push_back(Move(color, CAPTURE, origin, target));
-                break;
+                PieceType pt = PROMOTION_PIECES[i];
+                moves.push_back(Move(COLOR, PROMOTE, target - FORWARD, target,
+                        pt));
             }
-            moves.push_back(Move(color, QUIET, origin, target));
+        }
+    }
+}
 
-            // Is this a non-sliding piece?
-            if(!SLIDING[type])
-                break;
+template<bool COLOR>
+void Board::generatePawnCaptures(int origin, MoveList& moves) const
+{
+    const PieceType PAWN = (COLOR == WHITE) ? W_PAWN : B_PAWN;
+    const int PROMO_RANK = (COLOR == WHITE) ? 6 : 1;
+
+    // Can we capture things?
+    Bitboard targets = Geometry::leaps(PAWN, origin);
+    Bitboard captures = targets & by_color_[!COLOR];
+
+    while(!captures.empty())
+    {
+        int target = captures.popLowest();
+
+        // Are we currently on the second-to-last rank?
+        if(squareZ(origin) == PROMO_RANK)
+        {
+            // Iterate through all possible promotions
+            for(int i = 0; i < NUM_PROMOTION_PIECES; i++)
+            {
+                PieceType pt = PROMOTION_PIECES[i];
+                moves.push_back(Move(COLOR, PROMO_CAPTURE, origin, target, pt));
+            }
         }
+        else
+            moves.push_back(Move(COLOR, CAPTURE, origin, target));
     }
 
-    return moves;
+    // Can we perform en passant?
+    int ep_square = states_.back().ep_square;
+    if(ep_square != NO_EP_SQUARE && targets.test(ep_square))
+        moves.push_back(Move(COLOR, EN_PASSANT, origin, ep_square));
 }
 
-void Board::updateCastlingRights(bool color, int origin)
+uint64_t Board::computeHash() const
 {
-    // This means we only have to make one color lookup
-    int dist_from_king = origin - kingSquare(color);
-    int current_rights = castling_rights_.top();
+    uint64_t hash = 0;
 
-    // If we moved the king, remove all castling rights for that side
-    if(dist_from_king == 0)
+    for(int color = 0; color < 2; color++)
     {
-        castling_rights_.push(current_rights &~ castleMaskAll(color));
-        return;
+        for(int n = 0; n < num_pieces_[color]; n++)
+        {
+            int sq = piece_squares_[color][n];
+            hash ^= Zobrist::piece(pieces_[sq], sq);
+        }
     }
 
-    for(int i = 0; i < 6; i++)
+    hash ^= enPassantKey(states_.back().ep_square);
+    hash ^= Zobrist::castling(states_.back().castling_rights);
+
+    // The side key is toggled on every move
+    if(whoseTurn() == BLACK)
+        hash ^= Zobrist::side();
+
+    return hash;
+}
+
+uint64_t Board::computePawnHash() const
+{
+    uint64_t hash = 0;
+
+    for(int color = 0; color < 2; color++)
     {
-        // If we moved a rook, remove the rights just for that axis
-        if(dist_from_king == castleDir(i) * castleDist(i))
+        for(int n = 0; n < num_pieces_[color]; n++)
         {
-            castling_rights_.push(current_rights &~ castleMask(color, i));
-            return;
+            int sq = piece_squares_[color][n];
+            if(isPawn(pieces_[sq]))
+                hash ^= Zobrist::piece(pieces_[sq], sq);
         }
     }
 
-    // If we didn't move them at all, just keep the same rights
-    castling_rights_.push(current_rights);
+    return hash;
 }
 
-bool Board::isInSomemate(bool color) const
+Score Board::computePsqScore() const
 {
-    list<Move> moves = generatePseudoLegalMoves(color);
+    Score score;
 
-    list<Move>::const_iterator it;
-    for(it = moves.begin(); it != moves.end(); it++)
+    for(int color = 0; color < 2; color++)
     {
-        if(isLegalMove(*it))
+        for(int n = 0; n < num_pieces_[color]; n++)
         {
-            return false;
+            int sq = piece_squares_[color][n];
+            score += PieceSquare::piece(pieces_[sq], sq);
         }
     }
-    return true;
+
+    return score;
 }
+
+void Board::clearPieceLists()
+{
+    num_pieces_[WHITE] = 0;
+    num_pieces_[BLACK] = 0;
+
+    by_color_[WHITE] = Bitboard();
+    by_color_[BLACK] = Bitboard();
+
+    for(int pt = 0; pt < 16; pt++)
+        by_type_[pt] = Bitboard();
+
+    king_squares_[WHITE] = NO_SQUARE;
+    king_squares_[BLACK] = NO_SQUARE;
+
+    hash_ = 0;
+    pawn_hash_ = 0;
+    psq_ = Score();
+    phase_ = 0;
+
+    accumulator_.dirty[WHITE] = true;
+    accumulator_.dirty[BLACK] = true;
+}
+
+void Board::resetStates()
+{
+    StateInfo initial;
+    initial.move = Move();
+    initial.captured = Piece(NIL, WHITE);
+    initial.ep_square = NO_EP_SQUARE;
+    initial.castling_rights = ALL_CASTLING_RIGHTS;
+    initial.game_state = UNKNOWN_STATE;
+
+    states_.clear();
+    states_.reserve(RESERVED_PLIES);
+    states_.push_back(initial);
+
+    hash_ = computeHash();
+    states_.back().hash = hash_;
+}
+
+unsigned short Board::updateCastlingRights(unsigned short rights, bool color,
+        int origin)
+{
+    // This means we only have to make one color lookup
+    int dist_from_king = origin - kingSquare(color);
+
+    // If we moved the king, remove all castling rights for that side
+    if(dist_from_king == 0)
+        return rights &~ castleMaskAll(color);
+
+    for(int i = 0; i < 6; i++)
+    {
+        // If we moved a rook, remove the rights just for that axis
+        if(dist_from_king == castleDir(i) * castleDist(i))
+            return rights &~ castleMask(color, i);
+    }
+
+    // If we didn't move them at all, just keep the same rights
+    return rights;
+}
+
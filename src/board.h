@@ -1,12 +1,17 @@
 #ifndef CHESS_BOARD_H
 #define CHESS_BOARD_H
 
-#include <list>
-#include <stack>
+#include <cstdint>
+#include <string>
+#include <vector>
 
+#include "bitboard.h"
 #include "common.h"
 #include "move.h"
+#include "move-list.h"
+#include "nnue.h"
 #include "piece.h"
+#include "piece-square.h"
 
 /**
  * Represents the possible end states of the board, or that the game has not
@@ -17,6 +22,12 @@ enum GameState {
     STALEMATE_BLACK
 };
 
+/**
+ * The most pieces a side can have on the board at once: 64 pawns and 64
+ * pieces, as in the initial setup. Captures and promotions never add to this.
+ */
+const int MAX_PIECES = 128;
+
 /**
  * Represents an 8 x 8 x 8 chessboard, the pieces on it, and all necessary
  * metadata, such as move history, and if en passant is possible.
@@ -32,95 +43,415 @@ class Board
     /** Puts pieces on the board in their initial position. */
     void setup();
 
+    /**
+     * Sets up the position described by the given string, and clears the
+     * history. Returns false, leaving the board alone, if it can't be read.
+     *
+     * The string has four fields, separated by spaces. The first lists the
+     * pieces (see notation.h for the letters) level by level, starting with
+     * z = 0 and separated by '|'. Each level lists its rows, starting with
+     * y = 0 and separated by '/', and each row goes from x = 0 to 7, with a
+     * digit standing for that many empty squares. Then come the side to move
+     * ('w' or 'b'), the castling rights in hex ('-' for none), and the en
+     * passant square ('-' for none).
+     */
+    bool setPosition(const std::string& position);
+
+    /** Returns the string that setPosition would read this position from. */
+    std::string getPosition() const;
+
 
     /** Retrieves the piece at i. */
     Piece getPiece(int i) const;
 
-    /** Puts the specifed piece at i and returns the previous occupant. */
+    /**
+     * Puts the specifed piece at i and returns the previous occupant. If the
+     * piece's side already has MAX_PIECES others, the board is left as it
+     * was, and this returns the piece itself.
+     */
     Piece putPiece(const Piece& p, int i);
 
+    /**
+     * Returns the Zobrist hash of this position. Positions with the same
+     * pieces, castling rights, en passant square and side to move have the
+     * same hash.
+     */
+    uint64_t hash() const;
+
+    /**
+     * Returns the Zobrist hash of just the pawns: the XOR of the same keys
+     * that hash() uses, for the pawns alone. Positions with the same pawn
+     * structure have the same pawn hash.
+     */
+    uint64_t pawnHash() const;
+
+    /**
+     * Returns the sum of the PieceSquare scores of all the pieces, from
+     * White's point of view. Like the hash, it's kept up to date as pieces
+     * move, so this costs nothing.
+     */
+    const Score& psqScore() const;
+
+    /**
+     * Returns the game phase: the sum of PieceSquare::phase over all the
+     * pieces. It's MAX_PHASE in the initial setup, but promotions can take it
+     * higher.
+     */
+    int phase() const;
+
+    /**
+     * Returns the hidden layer of the active network (see activeNetwork) for
+     * this position. It's kept up to date as pieces move, except that a side
+     * whose king changes buckets has its half computed again here, as does
+     * everything when the active network has changed.
+     */
+    const Accumulator& accumulator() const;
+
+    /** Returns how many pieces (pawns included) the given color has. */
+    int countPieces(bool color) const;
+
+    /** Returns how many pieces of the given type and color there are. */
+    int countPieces(bool color, PieceType pt) const;
+
+    /** Returns the squares occupied by pieces of the given color. */
+    Bitboard pieces(bool color) const;
+
+    /** Returns the squares occupied by pieces of the given type and color. */
+    Bitboard pieces(bool color, PieceType pt) const;
+
+    /** Returns the squares occupied by any piece. */
+    Bitboard occupied() const;
+
+    /**
+     * Returns the square of the nth piece of the given color, where n is less
+     * than countPieces(color). The order changes as pieces are captured.
+     */
+    int getPieceSquare(bool color, int n) const;
+
     /** Returns true if the king of the specified color is in check. */
     bool isInCheck(bool color) const;
 
-    /** Returns the current state of the game (checkmate, stalemate, etc). */
+    /**
+     * Returns true if any piece of the specified color attacks the given
+     * square. This looks outward from the square, rather than generating the
+     * attacker's moves, so it is cheap enough to call for every candidate.
+     */
+    bool isSquareAttacked(int square, bool color) const;
+
+    /**
+     * Returns what the side making the given move gains from it, by
+     * PIECE_VALUES, once both sides have finished capturing on its target.
+     * Each side recaptures with its least valuable piece, and stops as soon
+     * as going on would lose more; sliders lined up behind the capturers
+     * along any of the 26 lines (x-rays) join in as the way clears. Pins,
+     * checks and promotions along the way are ignored.
+     */
+    int staticExchange(const Move& m) const;
+
+    /**
+     * Returns the color to move. This is the side to move in the position the
+     * board was set up in, flipped once for every move since.
+     */
+    bool whoseTurn() const;
+
+    /**
+     * Returns the current state of the game (checkmate, stalemate, etc). Only
+     * the side to move is examined, and the answer is remembered until the
+     * position changes.
+     */
     GameState getGameState() const;
 
-    /** Returns a const reference to the history of this board. */
-    const std::stack<Move>& getHistory() const;
+    /**
+     * Returns true if the given color has at least one legal move. This stops
+     * at the first one it finds, trying king steps and captures first.
+     */
+    bool hasLegalMove(bool color) const;
 
+    /** Returns the moves that have been made on this board, oldest first. */
+    std::vector<Move> getHistory() const;
 
-    /** Generates all pseudo-legal moves that the given color can make. */
-    std::list<Move> generatePseudoLegalMoves(int color) const;
 
     /**
-     * Generates all pseudo-legal moves that the piece on this square can make.
-     * It is safe to call this method on a non-piece (NIL or BORDER); it will
-     * just return an empty list.
+     * Appends all pseudo-legal moves that the given color can make to the
+     * list.
      */
-    std::list<Move> generateMoves(int origin) const;
+    void generatePseudoLegalMoves(int color, MoveList& moves) const;
 
-    /** Generates all pseudo-legal castling moves for the given team. */
-    std::list<Move> generateCastlingMoves(bool color) const;
+    /**
+     * Appends all pseudo-legal moves that the piece on this square can make
+     * to the list. It is safe to call this method on an empty square; it will
+     * just append nothing.
+     */
+    void generateMoves(int origin, MoveList& moves) const;
+
+    /** Appends all pseudo-legal castling moves for the given team. */
+    void generateCastlingMoves(bool color, MoveList& moves) const;
+
+    /**
+     * These three split up generatePseudoLegalMoves, for searches that would
+     * rather not generate everything at once. Between them, they produce
+     * each pseudo-legal move exactly once.
+     *
+     * generateCaptures appends the moves that take a piece: captures, en
+     * passant and promo-captures. generatePromotions appends the promotions
+     * that don't capture. generateQuiets appends everything else: quiet
+     * moves, double pawn pushes and castling.
+     */
+    void generateCaptures(bool color, MoveList& moves) const;
+    void generatePromotions(bool color, MoveList& moves) const;
+    void generateQuiets(bool color, MoveList& moves) const;
+
+    /**
+     * Returns true if the given move is one that generatePseudoLegalMoves
+     * could produce in this position. Moves remembered from other positions
+     * (such as from a transposition table) should be checked with this before
+     * being made.
+     */
+    bool isPseudoLegalMove(const Move& m) const;
+
+
+    /**
+     * Appends all legal moves that the given color can make to the list.
+     * This finds the pinned and checking pieces once, instead of trying out
+     * each move like isLegalMove does.
+     */
+    void generateLegalMoves(bool color, MoveList& moves) const;
 
 
     /** Returns true if the given move is legal for this configuration. */
     bool isLegalMove(const Move& m) const;
 
 
-    /** Performs the given move. Does not check for (pseudo-)legality. */
+    /**
+     * Performs the given move, which mustn't be nil. Does not check for
+     * (pseudo-)legality.
+     */
     void makeMove(const Move& m);
 
     /** Undoes the most recent move. Does nothing if there was none. */
     void undoMove();
 
+    /**
+     * Passes the turn without moving, for the search's null-move pruning.
+     * The side to move mustn't be in check. This has to be undone with
+     * undoNullMove, before any other move is undone.
+     */
+    void makeNullMove();
+
+    /** Undoes makeNullMove. */
+    void undoNullMove();
+
   private:
-    /** Generates all pseudo-legal moves for a pawn. */ 
-    std::list<Move> generatePawnMoves(int origin) const;
+    /**
+     * Which kinds of moves a generator should produce, as in the public
+     * generateCaptures, generatePromotions and generateQuiets. These are
+     * bits, and ALL_MOVES is all of them.
+     */
+    enum GenType { CAPTURES = 1, PROMOTIONS = 2, QUIETS = 4, ALL_MOVES = 7 };
 
-    /** Generates all pseudo-legal moves for a non-pawn piece. */ 
-    std::list<Move> generateNonPawnMoves(int origin) const;
+    /**
+     * Appends the pseudo-legal moves of kinds GT for the given color. The
+     * generators below are specialised on color, PieceType and GenType, so
+     * that the directions, the slider check, the pawn geometry and the kinds
+     * of moves wanted are all known at compile time. A side's pawns are
+     * assumed to be Piece::Pawn(color).
+     */
+    template<bool COLOR, GenType GT>
+    void generateAllMoves(MoveList& moves) const;
 
-    /** When a move is made, updates the castling rights accordingly. */
-    void updateCastlingRights(bool color, int origin);
+    /** Appends the moves of every piece of type PT and the given color. */
+    template<PieceType PT, GenType GT>
+    void generateTypeMoves(bool color, const Bitboard& occupied,
+            MoveList& moves) const;
 
-    /** Returns true if all moves for the given side put the king in check. */
-    bool isInSomemate(bool color) const;
+    /** Appends the moves of the non-pawn piece of type PT on origin. */
+    template<PieceType PT, GenType GT = ALL_MOVES>
+    void generatePieceMoves(int origin, bool color, const Bitboard& occupied,
+            MoveList& moves) const;
 
     /**
-     * Represents the pieces on the board. This is a "mailbox" representation,
-     * which is, apparently, a pretty common representation for chess engines.
-     *
-     * There are two parts to understanding this representation. The 8 x 8 x 8
-     * chessboard is centered inside a 12 x 12 x 12 cube. The edges of this
-     * cube are always set to the PieceType BORDER. This makes move generation
-     * much easier, because when a piece reaches the edge of the board, instead
-     * of "wrapping around", it hits the sentinel value of BORDER.
-     *
-     * The second part is that this 12 x 12 x 12 cube is unspooled into a
-     * linear array of size 1728. The x-coordinates vary first, then y, then z.
+     * Appends the pushes for all of the given pawns at once, working on whole
+     * sets of squares. Promotions count as PROMOTIONS, and the rest (including
+     * double pushes) as QUIETS.
      */
-    Piece pieces_ [1728];
+    template<bool COLOR, GenType GT = ALL_MOVES>
+    void generatePawnPushes(const Bitboard& pawns, MoveList& moves) const;
+
+    /** Appends the captures (including en passant) for a pawn. */
+    template<bool COLOR>
+    void generatePawnCaptures(int origin, MoveList& moves) const;
 
-    /** Contains all the moves that have been done on this board. */
-    std::stack<Move> history_;
+    /**
+     * Like isSquareAttacked, but looks at the board as if the piece on from
+     * had moved to to, and the piece on removed had been taken off the board.
+     * Unused arguments should be NO_SQUARE. The moving piece must not be one
+     * of the attackers.
+     */
+    bool isAttackedAfter(int square, bool color, int from, int to,
+            int removed) const;
+
+    /**
+     * Returns the pawns, leapers and kings of the given color that attack the
+     * square, out of the given set of pieces.
+     */
+    Bitboard leaperAttackers(int square, bool color,
+            const Bitboard& attackers) const;
+
+    /**
+     * Returns the pieces of the given color that slide along the given family
+     * of lines (a bit of SLIDER_LINES).
+     */
+    Bitboard slidersAlong(bool color, int line) const;
+
+    /**
+     * Returns the pieces of both colors that attack the square, if only the
+     * given squares were occupied. Pieces off of those squares are left out.
+     */
+    Bitboard attackersTo(int square, const Bitboard& occupied) const;
+
+    /**
+     * Puts a piece on an empty square, and adds it to the piece lists. The
+     * piece must be neither NIL nor BORDER.
+     */
+    void addPiece(const Piece& p, int i);
+
+    /** Removes the piece on i from the board and from the piece lists. */
+    void removePiece(int i);
+
+    /** Moves the piece on from to the empty square to. */
+    void movePiece(int from, int to);
+
+    /**
+     * Adds or subtracts the feature of piece p on i to the accumulator, for
+     * each side that isn't dirty. A side's own king can't be, since it moves
+     * every feature of that side, so that side becomes dirty instead.
+     */
+    void accumulate(const Piece& p, int i, bool add);
+
+    /**
+     * Computes the hash from scratch. hash_ should always equal this, which
+     * debug builds check after every move.
+     */
+    uint64_t computeHash() const;
+
+    /** Computes the pawn hash from scratch, as computeHash does the hash. */
+    uint64_t computePawnHash() const;
+
+    /**
+     * Computes the piece-square score from scratch. Like the hash, debug
+     * builds check it after every move.
+     */
+    Score computePsqScore() const;
 
     /**
-     * For each turn, contains the location of the en passant square, or 0 if
-     * there is none.
+     * Empties the piece lists (and hash), without touching pieces_. This
+     * leaves the accumulator dirty.
      */
-    std::stack<int> ep_locations_;
+    void clearPieceLists();
+
+    /** Clears the state history, leaving just the current position. */
+    void resetStates();
+
+    /**
+     * Returns the castling rights after the given color moves a piece off of
+     * origin, given the rights before.
+     */
+    static unsigned short updateCastlingRights(unsigned short rights,
+            bool color, int origin);
+
+    /**
+     * Represents the pieces on the board, one entry per square (see
+     * squareAt). There's no padding around the board: moves are walked with
+     * the precomputed steps in Geometry, which say when a piece would leave
+     * the board, so all 512 squares fit in a few cache lines.
+     */
+    Piece pieces_ [NUM_SQUARES];
+
+    /**
+     * Everything needed to undo a move, that can't be recovered from the
+     * position after it. There is one of these for each ply.
+     */
+    struct StateInfo
+    {
+        /** The move that led to this state. Nil for the initial state. */
+        Move move;
+
+        /** The piece that move captured, or NIL. (Except for en passant.) */
+        Piece captured;
+
+        /** The location of the en passant square, or -1 if there is none. */
+        int ep_square;
+
+        /**
+         * The nth bit is set if White has castling rights along the nth axis,
+         * and the n+6th bit is set if Black does. (6 axes each)
+         */
+        unsigned short castling_rights;
+
+        /** The Zobrist hash of the position in this state. */
+        uint64_t hash;
+
+        /**
+         * The GameState of this position, or -1 if it hasn't been asked for
+         * yet. It's filled in lazily by getGameState, hence mutable.
+         */
+        mutable signed char game_state;
+    };
+
+    /**
+     * The state of every ply so far, starting with the initial position. The
+     * last entry is the current state. Making a move appends to this, and
+     * undoing one pops from it; the storage is reserved ahead of time.
+     */
+    std::vector<StateInfo> states_;
+
+    /**
+     * The squares of each color's pieces, indexed by color. Only the first
+     * num_pieces_[color] entries are meaningful, and they're in no particular
+     * order.
+     */
+    short piece_squares_ [2][MAX_PIECES];
+
+    /** How many pieces each color has. */
+    int num_pieces_ [2];
+
+    /**
+     * For each occupied square, the index of its piece in piece_squares_.
+     * Meaningless for empty squares.
+     */
+    unsigned char piece_indices_ [NUM_SQUARES];
+
+    /** The squares occupied by each color's pieces, indexed by color. */
+    Bitboard by_color_ [2];
+
+    /**
+     * The squares occupied by each PieceType, of either color. Intersect with
+     * by_color_ to get one side's pieces.
+     */
+    Bitboard by_type_ [16];
+
+    /** The color to move in the first of states_. */
+    bool first_turn_;
+
+    /** The Zobrist hash of the position, and of its pawns alone. */
+    uint64_t hash_;
+    uint64_t pawn_hash_;
+
+    /** The piece-square score and the phase, updated with every change. */
+    Score psq_;
+    int phase_;
 
     /**
-     * For each turn, the nth bit is set if White has castling rights along
-     * the nth axis, and the n+6th bit is set if Black does. (6 axes each)
+     * The square each king is on, indexed by color, or NO_SQUARE if that side
+     * has no king. Kept up to date by makeMove, undoMove and putPiece.
      */
-    std::stack<unsigned short> castling_rights_;
+    int king_squares_ [2];
 
     /**
-     * Contains the pieces captured during this game in order. Note that this
-     * is _not_ a per-turn structure.
+     * The hidden layer of the network the board was last evaluated with. It's
+     * brought up to date lazily by accumulator(), hence mutable.
      */
-    std::stack<Piece> captured_;
+    mutable Accumulator accumulator_;
 };
 
 #endif
@@ -1,31 +1,34 @@
 #ifndef CHESS_COMMON_H
 #define CHESS_COMMON_H
 
+/** The number of squares on the board. */
+const int NUM_SQUARES = 512;
+
 /**
- * Converts from an 8 x 8 x 8 cube to a 1728 array. The x-coordinates vary
- * first, then y, then z.
+ * Converts from an 8 x 8 x 8 cube to a square index from 0 to 511. The
+ * x-coordinates vary first, then y, then z.
  */
-inline int mailbox(int x, int y, int z)
+inline int squareAt(int x, int y, int z)
 {
-    return (z + 2) * 144 + (y + 2) * 12 + (x + 2);
+    return (z << 6) | (y << 3) | x;
 }
 
-/** Converts from a 1728 array to the x-coordinate of an 8 x 8 x 8 cube. */
-inline int unmailboxX(int i)
+/** Converts from a square index to the x-coordinate of an 8 x 8 x 8 cube. */
+inline int squareX(int i)
 {
-    return (i % 12) - 2;
+    return i & 7;
 }
 
-/** Converts from a 1728 array to the y-coordinate of an 8 x 8 x 8 cube. */
-inline int unmailboxY(int i)
+/** Converts from a square index to the y-coordinate of an 8 x 8 x 8 cube. */
+inline int squareY(int i)
 {
-    return (i / 12) % 12 - 2;
+    return (i >> 3) & 7;
 }
 
-/** Converts from a 1728 array to the z-coordinate of an 8 x 8 x 8 cube. */
-inline int unmailboxZ(int i)
+/** Converts from a square index to the z-coordinate of an 8 x 8 x 8 cube. */
+inline int squareZ(int i)
 {
-    return (i / 144) % 12 - 2;
+    return i >> 6;
 }
 
 #endif
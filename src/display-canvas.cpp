@@ -11,7 +11,6 @@ using glm::mat4;
 using glm::vec3;
 using glm::vec4;
 
-using std::list;
 using std::string;
 
 /** Pi */
@@ -37,7 +36,7 @@ static const char* PIECE_FILES [16] = {
 };
 
 /** Represents that there is no selected cell. */
-static const int NO_SELECTION = 0;
+static const int NO_SELECTION = -1;
 
 //----CLASS METHODS----
 
@@ -335,10 +334,10 @@ void DisplayCanvas::click(int i, int j, int k)
         return;
 
     bool turn = player_.whoseTurn();
-    int clickedIndex = mailbox(i, j, k);
+    int clickedIndex = squareAt(i, j, k);
 
     // Check if we clicked on a move indicator
-    list< ::Move>::const_iterator it;
+    const ::Move* it;
     for(it = selected_moves_.begin(); it != selected_moves_.end(); it++)
     {
         if(clickedIndex == it->target())
@@ -364,18 +363,13 @@ void DisplayCanvas::click(int i, int j, int k)
     if(clickedPiece.isOn(turn))
     {
         selected_cell_ = clickedIndex;
-        list< ::Move> moves = board_.generateMoves(clickedIndex);
-        if(clickedPiece.type() == KING)
-        {
-            list< ::Move> castles = board_.generateCastlingMoves(turn);
-            moves.splice(moves.end(), castles);
-        }
-        
-        // Restrict to legal moves
+        MoveList moves;
+        board_.generateLegalMoves(turn, moves);
+
+        // Restrict to the moves of the clicked piece
         selected_moves_.clear();
-        list< ::Move>::const_iterator it;
         for(it = moves.begin(); it != moves.end(); it++)
-            if(board_.isLegalMove(*it))
+            if(it->origin() == clickedIndex)
                 selected_moves_.push_back(*it);
 
         Refresh();
@@ -473,7 +467,7 @@ void DisplayCanvas::renderPieces()
             for(int k = 0; k < 8; k++)
             {
                 // Find piece data
-                Piece p = board_.getPiece(mailbox(i, j, k));
+                Piece p = board_.getPiece(squareAt(i, j, k));
 
                 // Compute model matrix
                 mat4 model;
@@ -496,7 +490,7 @@ void DisplayCanvas::renderPieces()
 
                 // Compute hue
                 PieceType pt = p.type();
-                if(pt == NIL || pt == BORDER)
+                if(pt == NIL)
                     continue;
                 int tmp = (pt == W_PAWN) ? B_PAWN : pt; // Makes pawns match
                 float hue = tmp * (360.0f / 13);
@@ -537,13 +531,13 @@ void DisplayCanvas::renderIndicators()
     GLuint vp_loc = glGetUniformLocation(program, "VP");
     glUniformMatrix4fv(vp_loc, 1, false, glm::value_ptr(vp));
 
-    std::list< ::Move>::const_iterator it;
+    const ::Move* it;
     for(it = selected_moves_.begin(); it != selected_moves_.end(); it++)
     {
         // Get the target square of the move
-        int x = unmailboxX(it->target());
-        int y = unmailboxY(it->target());
-        int z = unmailboxZ(it->target());
+        int x = squareX(it->target());
+        int y = squareY(it->target());
+        int z = squareZ(it->target());
 
         // Compute model matrix
         vec3 corner = vec3(x - 4, y - 4, z - 4);
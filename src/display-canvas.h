@@ -9,12 +9,12 @@
 
 #include <glm/glm.hpp>
 
-#include <list>
 #include <string>
 
 #include "common.h"
 #include "human-player.h"
 #include "game.h"
+#include "move-list.h"
 #include "piece.h"
 #include "view-interface.h"
 
@@ -159,7 +159,7 @@ class DisplayCanvas : public wxGLCanvas, public ViewInterface
     int selected_cell_;
 
     /** The moves the selected piece can make. */
-    std::list< ::Move> selected_moves_;
+    MoveList selected_moves_;
 };
 
 #endif
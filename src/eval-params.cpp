@@ -0,0 +1,187 @@
+#include "eval-params.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "notation.h"
+
+/** The names of the terms, by EvalParam, for the first entry of each. */
+static const struct {
+    int first;
+    int count;
+    const char* name;
+} TERMS [] = {
+    { MATERIAL, 16, "material" },
+    { CENTER, 16, "center" },
+    { ADVANCE, 16, "advance" },
+    { FILES, 16, "files" },
+    { PASSED, 8, "passed" },
+    { ISOLATED, 1, "isolated" },
+    { DOUBLED, 1, "doubled" },
+    { BACKWARD, 1, "backward" }
+};
+
+static const int NUM_TERMS = sizeof(TERMS) / sizeof(TERMS[0]);
+
+/** The parameters in use. */
+static EvalParams current;
+
+EvalParams::EvalParams()
+{
+    for(int pt = W_PAWN; pt <= KING; pt++)
+        scores[MATERIAL + pt] = Score(PIECE_VALUES[pt], PIECE_VALUES[pt]);
+
+    // Pawns are worth more the further they've gone, most of all in the
+    // endgame, and more in the middle files early on
+    scores[MATERIAL + W_PAWN].eg = 130;
+    scores[ADVANCE + W_PAWN] = Score(3, 8);
+    scores[FILES + W_PAWN] = Score(1, 0);
+
+    // Pieces with a short reach care most about being in the middle, where
+    // they reach the most squares
+    for(int pt = KNIGHT; pt <= DRAGON; pt++)
+        scores[CENTER + pt] = Score(3, 2);
+    scores[CENTER + UNICORN] = Score(2, 2);
+    scores[CENTER + ROOK] = Score(0, 1);
+    for(int pt = BISHOP; pt <= CANNON; pt++)
+        scores[CENTER + pt] = Score(1, 1);
+    scores[CENTER + QUEEN] = Score(1, 2);
+
+    // The king stays home until the endgame, when it comes out to fight
+    scores[ADVANCE + KING] = Score(-12, 0);
+    scores[CENTER + KING] = Score(0, 3);
+
+    const Score PASSED_PAWNS [8] = {
+        Score(0, 0), Score(0, 0), Score(5, 10), Score(10, 20),
+        Score(20, 35), Score(35, 60), Score(55, 90), Score(0, 0)
+    };
+    for(int rank = 0; rank < 8; rank++)
+        scores[PASSED + rank] = PASSED_PAWNS[rank];
+
+    scores[ISOLATED] = Score(-10, -15);
+    scores[DOUBLED] = Score(-10, -20);
+    scores[BACKWARD] = Score(-8, -10);
+}
+
+std::string EvalParams::name(int param)
+{
+    for(int t = 0; t < NUM_TERMS; t++)
+    {
+        int n = param - TERMS[t].first;
+        if(n < 0 || n >= TERMS[t].count)
+            continue;
+
+        if(TERMS[t].count == 1)
+            return TERMS[t].name;
+
+        std::ostringstream name;
+        name << TERMS[t].name << '.';
+        if(TERMS[t].count == 8)
+            name << n;
+        else if(n >= W_PAWN && n != B_PAWN)
+            name << pieceLetter(Piece((PieceType) n, WHITE));
+        else
+            return "";
+        return name.str();
+    }
+
+    return "";
+}
+
+bool EvalParams::load(const std::string& path)
+{
+    std::ifstream in (path.c_str());
+    if(!in)
+        return false;
+
+    EvalParams loaded = *this;
+    std::string line;
+    while(std::getline(in, line))
+    {
+        std::istringstream fields (line);
+        std::string name;
+        Score s;
+        if(!(fields >> name))
+            continue;
+        if(!(fields >> s.mg >> s.eg))
+            return false;
+
+        int param = 0;
+        while(param < NUM_EVAL_PARAMS && (name != EvalParams::name(param)))
+            param++;
+        if(param == NUM_EVAL_PARAMS)
+            return false;
+
+        loaded.scores[param] = s;
+    }
+
+    *this = loaded;
+    return true;
+}
+
+bool EvalParams::save(const std::string& path) const
+{
+    FILE* f = fopen(path.c_str(), "w");
+    if(f == NULL)
+        return false;
+
+    for(int param = 0; param < NUM_EVAL_PARAMS; param++)
+    {
+        std::string name = EvalParams::name(param);
+        if(!name.empty())
+            fprintf(f, "%s %d %d\n", name.c_str(), scores[param].mg,
+                    scores[param].eg);
+    }
+
+    return fclose(f) == 0;
+}
+
+int centerTerm(int square)
+{
+    // The number of king steps along each axis to the central cube
+    int dx = abs(2 * squareX(square) - 7) / 2;
+    int dy = abs(2 * squareY(square) - 7) / 2;
+    int dz = abs(2 * squareZ(square) - 7) / 2;
+    return 9 - 2 * (dx + dy + dz);
+}
+
+int advanceTerm(int square)
+{
+    return squareZ(square) - 1;
+}
+
+int filesTerm(int square)
+{
+    return 7 - abs(2 * squareX(square) - 7) - abs(2 * squareY(square) - 7);
+}
+
+EvalTrace::EvalTrace() : phase(0)
+{
+    for(int param = 0; param < NUM_EVAL_PARAMS; param++)
+        coefs[param] = 0;
+}
+
+Score EvalTrace::score(const EvalParams& params) const
+{
+    Score total;
+    for(int param = 0; param < NUM_EVAL_PARAMS; param++)
+    {
+        total.mg += coefs[param] * params.scores[param].mg;
+        total.eg += coefs[param] * params.scores[param].eg;
+    }
+
+    return total;
+}
+
+const EvalParams& evalParams()
+{
+    return current;
+}
+
+void setEvalParams(const EvalParams& params)
+{
+    current = params;
+    PieceSquare::setParams(params);
+}
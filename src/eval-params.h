@@ -0,0 +1,107 @@
+#ifndef CHESS_EVALPARAMS_H
+#define CHESS_EVALPARAMS_H
+
+#include <string>
+
+#include "common.h"
+#include "piece-square.h"
+
+/**
+ * The indices of the handcrafted evaluation's parameters, each a Score.
+ * The first four terms have one entry per PieceType (pawns of both colors use
+ * W_PAWN's); the rest are single entries, except PASSED, which has one for
+ * each rank.
+ */
+enum EvalParam {
+    MATERIAL = 0,
+    CENTER = MATERIAL + 16,
+    ADVANCE = CENTER + 16,
+    FILES = ADVANCE + 16,
+    PASSED = FILES + 16,
+    ISOLATED = PASSED + 8,
+    DOUBLED,
+    BACKWARD,
+    NUM_EVAL_PARAMS
+};
+
+/**
+ * The weights of the handcrafted evaluation, which bin/tune tunes. A piece's
+ * piece-square score is its MATERIAL, plus CENTER, ADVANCE and FILES each
+ * times the matching term of its square (see centerTerm, advanceTerm and
+ * filesTerm); the pawn structure is scored with the rest (see
+ * evaluatePawns).
+ *
+ * Parameters are saved as text, one per line: the name, then the middlegame
+ * and endgame values, like "material.N 300 300". The names are the term, in
+ * lower case, then (for the per-piece terms) the piece's letter or (for
+ * PASSED) the rank.
+ */
+struct EvalParams
+{
+    /** Constructs the default parameters. */
+    EvalParams();
+
+    /**
+     * Returns the name of the given parameter, or an empty string if it's
+     * one that isn't used (such as MATERIAL + NIL).
+     */
+    static std::string name(int param);
+
+    /**
+     * Reads parameters from a file, over the ones already here; parameters
+     * the file leaves out keep their values. Returns false, leaving these
+     * alone, if the file can't be read or has a line that isn't a parameter.
+     */
+    bool load(const std::string& path);
+
+    /** Writes every used parameter to a file. Returns false if it can't. */
+    bool save(const std::string& path) const;
+
+    /** The parameters, indexed by EvalParam. */
+    Score scores [NUM_EVAL_PARAMS];
+};
+
+/**
+ * The terms of a square that a piece's placement is scored by, from White's
+ * point of view. centerTerm goes from 9 in the middle 2 x 2 x 2 cube down to
+ * -9 in the corners; advanceTerm is how many levels the square is past the
+ * second (z = 1); and filesTerm goes from 7 on the central files (columns
+ * along z) down to -7 on the corner files.
+ */
+int centerTerm(int square);
+int advanceTerm(int square);
+int filesTerm(int square);
+
+/**
+ * How much each parameter counts towards a position's score, which is linear
+ * in them: the middlegame score is the sum of each coefficient times the
+ * parameter's middlegame value, and the same for the endgame. Coefficients
+ * are from White's point of view, so Black's pieces count negatively.
+ */
+struct EvalTrace
+{
+    /** Constructs a trace with every coefficient 0. */
+    EvalTrace();
+
+    /** Returns the score the trace adds up to, with the given parameters. */
+    Score score(const EvalParams& params) const;
+
+    /** The coefficients, indexed by EvalParam. */
+    int coefs [NUM_EVAL_PARAMS];
+
+    /** The phase of the position, capped at MAX_PHASE. */
+    int phase;
+};
+
+/** Returns the parameters in use. */
+const EvalParams& evalParams();
+
+/**
+ * Starts using the given parameters, recomputing the piece-square tables.
+ * Boards keep the piece-square score they had until they're set up again,
+ * and pawn tables keep theirs, so this should be called before setting up
+ * the boards to evaluate, and never while searching.
+ */
+void setEvalParams(const EvalParams& params);
+
+#endif
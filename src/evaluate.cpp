@@ -0,0 +1,68 @@
+#include "evaluate.h"
+
+#include <algorithm>
+
+#include "nnue.h"
+
+int evaluate(const Board& board, PawnTable* pawns)
+{
+    const Network* network = activeNetwork();
+    if(network != NULL)
+        return evaluateNetwork(*network, board.accumulator(),
+                               board.whoseTurn());
+
+    Score total = board.psqScore();
+    if(pawns != NULL)
+        total += pawns->probe(board).score;
+    else
+    {
+        PawnEntry entry;
+        evaluatePawns(board, entry);
+        total += entry.score;
+    }
+
+    // Blend the middlegame and endgame scores by how much material is left
+    int phase = std::min(board.phase(), MAX_PHASE);
+    int score = (total.mg * phase + total.eg * (MAX_PHASE - phase)) /
+            MAX_PHASE;
+
+    return (board.whoseTurn() == WHITE) ? score : -score;
+}
+
+void traceEvaluation(const Board& board, EvalTrace& trace)
+{
+    trace = EvalTrace();
+    trace.phase = std::min(board.phase(), MAX_PHASE);
+
+    for(int color = 0; color < 2; color++)
+    {
+        int sign = (color == WHITE) ? 1 : -1;
+        for(int n = 0; n < board.countPieces(color); n++)
+        {
+            int sq = board.getPieceSquare(color, n);
+            PieceType pt = board.getPiece(sq).type();
+
+            // Black's pieces are scored as White's, with the levels flipped
+            if(color == BLACK)
+                sq = squareAt(squareX(sq), squareY(sq), 7 - squareZ(sq));
+
+            int table = (pt == B_PAWN) ? W_PAWN : pt;
+            trace.coefs[MATERIAL + table] += sign;
+            trace.coefs[CENTER + table] += sign * centerTerm(sq);
+            trace.coefs[ADVANCE + table] += sign * advanceTerm(sq);
+            trace.coefs[FILES + table] += sign * filesTerm(sq);
+        }
+    }
+
+    PawnEntry entry;
+    evaluatePawns(board, entry, &trace);
+}
+
+int nonPawnMaterial(const Board& board, bool color)
+{
+    int material = 0;
+    for(int pt = KNIGHT; pt < KING; pt++)
+        material += PIECE_VALUES[pt] * board.countPieces(color, (PieceType) pt);
+
+    return material;
+}
@@ -0,0 +1,36 @@
+#ifndef CHESS_EVALUATE_H
+#define CHESS_EVALUATE_H
+
+#include "board.h"
+#include "pawn-table.h"
+
+/**
+ * Returns a static score for the position, in hundredths of a pawn, from the
+ * point of view of the side to move: positive if it's ahead. This is the
+ * board's piece-square score (see PieceSquare), plus the score of the pawn
+ * structure (see evaluatePawns), blended from the middlegame score to the
+ * endgame score as the phase falls.
+ *
+ * The pawn structure is looked up in the given table, if there is one, and
+ * scored from scratch otherwise.
+ *
+ * If a network has been loaded (see activeNetwork), its score is used
+ * instead of all of that.
+ */
+int evaluate(const Board& board, PawnTable* pawns = NULL);
+
+/**
+ * Fills in the trace of the handcrafted evaluation of the position: how much
+ * each of the EvalParams counts towards the score before it's blended, from
+ * White's point of view. With the parameters in use, the trace's score is the
+ * board's piece-square score plus the pawns' score. This is for tuning.
+ */
+void traceEvaluation(const Board& board, EvalTrace& trace);
+
+/**
+ * Returns the value of the given color's pieces, by PIECE_VALUES, not
+ * counting pawns or the king.
+ */
+int nonPawnMaterial(const Board& board, bool color);
+
+#endif
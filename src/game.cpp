@@ -36,6 +36,11 @@ void Game::run()
     while(!interrupted_ && board_.getGameState() == IN_PROGRESS)
     {
         Move m = players_[turn_]->requestMove(turn_, board_);
+
+        // An interrupted player answers with a nil move, which isn't one
+        if(interrupted_ || m == Move())
+            break;
+
         board_.makeMove(m);
         turn_ = !turn_;
     }
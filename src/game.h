@@ -1,6 +1,7 @@
 #ifndef CHESS_GAME_H
 #define CHESS_GAME_H
 
+#include <atomic>
 #include <stack>
 #include <thread>
 
@@ -59,7 +60,7 @@ class Game
     Board board_;
 
     /** If another thread has called for the game to end. */
-    bool interrupted_;
+    std::atomic<bool> interrupted_;
 
     /**
      * When a move is undone, it's pushed onto this stack. This allows redoing
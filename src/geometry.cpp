@@ -0,0 +1,105 @@
+#include "geometry.h"
+
+/** The (dx, dy, dz) of each step, in the order described in geometry.h. */
+static const int OFFSETS [NUM_OFFSETS][3] = {
+    /* Rook lines */
+    { 1, 0, 0}, { 0, 1, 0}, { 0, 0, 1}, {-1, 0, 0}, { 0,-1, 0}, { 0, 0,-1},
+
+    /* Bishop lines */
+    { 1, 1, 0}, {-1, 1, 0}, { 1, 0, 1}, {-1, 0, 1}, { 0, 1, 1}, { 0,-1, 1},
+    {-1,-1, 0}, { 1,-1, 0}, {-1, 0,-1}, { 1, 0,-1}, { 0,-1,-1}, { 0, 1,-1},
+
+    /* Mace lines */
+    { 1, 1, 1}, {-1, 1, 1}, { 1,-1, 1}, {-1,-1, 1},
+    {-1,-1,-1}, { 1,-1,-1}, {-1, 1,-1}, { 1, 1,-1},
+
+    /* Knight */
+    { 2, 1, 0}, {-2, 1, 0}, { 1, 2, 0}, {-1, 2, 0}, { 2, 0, 1}, {-2, 0, 1},
+    { 1, 0, 2}, {-1, 0, 2}, { 0, 2, 1}, { 0,-2, 1}, { 0, 1, 2}, { 0,-1, 2},
+    {-2,-1, 0}, { 2,-1, 0}, {-1,-2, 0}, { 1,-2, 0}, {-2, 0,-1}, { 2, 0,-1},
+    {-1, 0,-2}, { 1, 0,-2}, { 0,-2,-1}, { 0, 2,-1}, { 0,-1,-2}, { 0, 1,-2},
+
+    /* Griffin */
+    { 2, 1, 1}, {-2, 1, 1}, { 2,-1, 1}, {-2,-1, 1}, { 1, 2, 1}, { 1,-2, 1},
+    {-1, 2, 1}, {-1,-2, 1}, { 1, 1, 2}, {-1,-1, 2}, {-1, 1, 2}, { 1,-1, 2},
+    {-2,-1,-1}, { 2,-1,-1}, {-2, 1,-1}, { 2, 1,-1}, {-1,-2,-1}, {-1, 2,-1},
+    { 1,-2,-1}, { 1, 2,-1}, {-1,-1,-2}, { 1, 1,-2}, { 1,-1,-2}, {-1, 1,-2},
+
+    /* Dragon */
+    { 1, 2, 2}, {-1, 2, 2}, { 1,-2, 2}, {-1,-2, 2}, { 2, 1, 2}, { 2,-1, 2},
+    {-2, 1, 2}, {-2,-1, 2}, { 2, 2, 1}, {-2,-2, 1}, {-2, 2, 1}, { 2,-2, 1},
+    {-1,-2,-2}, { 1,-2,-2}, {-1, 2,-2}, { 1, 2,-2}, {-2,-1,-2}, {-2, 1,-2},
+    { 2,-1,-2}, { 2, 1,-2}, {-2,-2,-1}, { 2, 2,-1}, { 2,-2,-1}, {-2, 2,-1}
+};
+
+Geometry::Tables::Tables()
+{
+    for(int sq = 0; sq < NUM_SQUARES; sq++)
+    {
+        for(int n = 0; n < NUM_OFFSETS; n++)
+        {
+            int x = squareX(sq) + OFFSETS[n][0];
+            int y = squareY(sq) + OFFSETS[n][1];
+            int z = squareZ(sq) + OFFSETS[n][2];
+
+            bool on_board = (x >= 0 && x < 8) && (y >= 0 && y < 8) &&
+                            (z >= 0 && z < 8);
+            steps[sq][n] = on_board ? squareAt(x, y, z) : OFF_BOARD;
+        }
+    }
+
+    for(int dir = 0; dir < NUM_LINES; dir++)
+    {
+        const int* d = OFFSETS[dir];
+        ascending[dir] = (d[2] * 64 + d[1] * 8 + d[0] > 0);
+        climb[dir] = d[2];
+    }
+
+    for(int sq = 0; sq < NUM_SQUARES; sq++)
+    {
+        // Walk every line out to the edge of the board
+        for(int dir = 0; dir < NUM_LINES; dir++)
+        {
+            for(int t = steps[sq][dir]; t != OFF_BOARD; t = steps[t][dir])
+                rays[sq][dir].set(t);
+        }
+
+        // The king takes one step along any line. A pawn captures by taking
+        // one along a line that goes forward, but not straight forward.
+        for(int n = 0; n < NUM_LINES; n++)
+        {
+            int t = steps[sq][n];
+            if(t == OFF_BOARD)
+                continue;
+
+            leaps[KING][sq].set(t);
+
+            const int* d = OFFSETS[n];
+            bool diagonal = (d[0] != 0 || d[1] != 0);
+            if(d[2] == 1 && diagonal)
+                leaps[W_PAWN][sq].set(t);
+            if(d[2] == -1 && diagonal)
+                leaps[B_PAWN][sq].set(t);
+        }
+
+        // The leapers each have their own group of offsets
+        for(int n = 0; n < 24; n++)
+        {
+            int knight = steps[sq][KNIGHT_OFFSETS + n];
+            int griffin = steps[sq][GRIFFIN_OFFSETS + n];
+            int dragon = steps[sq][DRAGON_OFFSETS + n];
+
+            if(knight != OFF_BOARD)
+                leaps[KNIGHT][sq].set(knight);
+            if(griffin != OFF_BOARD)
+                leaps[GRIFFIN][sq].set(griffin);
+            if(dragon != OFF_BOARD)
+                leaps[DRAGON][sq].set(dragon);
+        }
+
+        leaps[UNICORN][sq] = leaps[KNIGHT][sq] | leaps[GRIFFIN][sq] |
+                             leaps[DRAGON][sq];
+    }
+}
+
+const Geometry::Tables Geometry::tables_;
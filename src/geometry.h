@@ -0,0 +1,143 @@
+#ifndef CHESS_GEOMETRY_H
+#define CHESS_GEOMETRY_H
+
+#include "bitboard.h"
+#include "common.h"
+#include "piece.h"
+
+/**
+ * The number of distinct steps a piece can take. The first 26 are the single
+ * steps in every direction: 6 along the rook lines, 12 along the bishop
+ * lines, and 8 along the mace lines. After those come the 24 knight leaps,
+ * the 24 griffin leaps, and the 24 dragon leaps. In each group, the second
+ * half of the steps are the first half reversed.
+ */
+const int NUM_OFFSETS = 98;
+
+/** The number of single-step directions, i.e., lines through a square. */
+const int NUM_LINES = 26;
+
+/** Where the bishop and mace lines start among the offsets. */
+const int BISHOP_LINES = 6;
+const int MACE_LINES = 18;
+
+/** Where each group of leaps starts among the offsets. */
+const int KNIGHT_OFFSETS = 26;
+const int GRIFFIN_OFFSETS = 50;
+const int DRAGON_OFFSETS = 74;
+
+/** The result of a step that would leave the board. */
+const int OFF_BOARD = -1;
+
+/**
+ * Precomputed tables describing how squares relate to each other. Looking up
+ * a step here replaces both the offset arithmetic and the border check.
+ */
+class Geometry
+{
+  public:
+    /**
+     * Returns the square reached by taking the given step from sq, or
+     * OFF_BOARD if that would leave the board.
+     */
+    static int step(int sq, int offset)
+    {
+        return tables_.steps[sq][offset];
+    }
+
+    /**
+     * Returns the squares attacked from sq by a piece of the given type, which
+     * must be a pawn, a leaper (KNIGHT, GRIFFIN, DRAGON, UNICORN) or a KING.
+     * For pawns, these are the capture targets.
+     */
+    static const Bitboard& leaps(PieceType pt, int sq)
+    {
+        return tables_.leaps[pt][sq];
+    }
+
+    /**
+     * Returns the squares on the line from sq in the given direction (one of
+     * the first NUM_LINES offsets), not including sq itself.
+     */
+    static const Bitboard& ray(int sq, int dir)
+    {
+        return tables_.rays[sq][dir];
+    }
+
+    /**
+     * Returns the first occupied square on the ray from sq in the given
+     * direction, or OFF_BOARD if there isn't one.
+     */
+    static int firstBlocker(int sq, int dir, const Bitboard& occupied)
+    {
+        const Bitboard& r = ray(sq, dir);
+        int z = sq >> 6;
+        int dz = tables_.climb[dir];
+
+        // A ray that stays on its level is all in one word, and squares
+        // further along it are higher if the step is positive
+        if(dz == 0)
+        {
+            uint64_t blockers = r.word(z) & occupied.word(z);
+            if(blockers == 0)
+                return OFF_BOARD;
+
+            int bit = tables_.ascending[dir] ? __builtin_ctzll(blockers)
+                                             : 63 - __builtin_clzll(blockers);
+            return (z << 6) | bit;
+        }
+
+        // Otherwise, it has one square on each level it passes through
+        for(z += dz; z >= 0 && z < 8; z += dz)
+        {
+            uint64_t blockers = r.word(z) & occupied.word(z);
+            if(blockers != 0)
+                return (z << 6) | __builtin_ctzll(blockers);
+        }
+
+        return OFF_BOARD;
+    }
+
+    /**
+     * Returns the squares a slider on sq reaches in the given direction: the
+     * ray up to and including the first occupied square.
+     */
+    static Bitboard slide(int sq, int dir, const Bitboard& occupied)
+    {
+        int blocker = firstBlocker(sq, dir, occupied);
+        if(blocker == OFF_BOARD)
+            return ray(sq, dir);
+        return ray(sq, dir) ^ ray(blocker, dir);
+    }
+
+  private:
+    /** All the tables, computed once at startup. */
+    struct Tables
+    {
+        /** Fills in the tables. */
+        Tables();
+
+        /** Indexed by square and offset. */
+        short steps [NUM_SQUARES][NUM_OFFSETS];
+
+        /** Indexed by PieceType and square. Only the leapers are filled in. */
+        Bitboard leaps [16][NUM_SQUARES];
+
+        /** Indexed by square and direction. */
+        Bitboard rays [NUM_SQUARES][NUM_LINES];
+
+        /** Whether each direction goes towards higher square indices. */
+        bool ascending [NUM_LINES];
+
+        /** How each direction changes z: -1, 0 or 1. */
+        int climb [NUM_LINES];
+    };
+
+    /**
+     * The tables themselves. They're filled in during static initialization,
+     * so no Board should be used from another static initializer.
+     */
+    static const Tables tables_;
+};
+
+#endif
@@ -0,0 +1,31 @@
+#include "history.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+const int History::MAX_HISTORY;
+
+History::History() : scores_(2 * NUM_SQUARES * NUM_SQUARES, 0)
+{
+}
+
+void History::update(const Move& m, int bonus)
+{
+    // The closer the score is to the limit, the less the bonus moves it, so
+    // it can never get past
+    bonus = std::max(-MAX_HISTORY, std::min(bonus, MAX_HISTORY));
+
+    int16_t& s = scores_[index(m)];
+    s += bonus - s * abs(bonus) / MAX_HISTORY;
+}
+
+void History::age()
+{
+    for(size_t i = 0; i < scores_.size(); i++)
+        scores_[i] /= 2;
+}
+
+void History::clear()
+{
+    std::fill(scores_.begin(), scores_.end(), 0);
+}
@@ -0,0 +1,57 @@
+#ifndef CHESS_HISTORY_H
+#define CHESS_HISTORY_H
+
+#include <cstdint>
+#include <vector>
+
+#include "common.h"
+#include "move.h"
+
+/**
+ * The history heuristic: a score for every quiet move, by color, origin and
+ * target (a "butterfly" table), of how often it has caused a cutoff. Moves
+ * that did are rewarded, and the quiet moves tried before them are
+ * penalised, by amounts that grow with the depth. Scores are pulled back
+ * towards 0 as they grow, so they stay within MAX_HISTORY.
+ *
+ * A table lasts from search to search, since good moves tend to stay good,
+ * but it's aged in between, so that old results count for less. Each search
+ * thread has its own.
+ */
+class History
+{
+  public:
+    /** The largest a score can get, either way. */
+    static const int MAX_HISTORY = 8192;
+
+    /** Constructs a table with every score 0. */
+    History();
+
+    /** Returns the score of the given move. */
+    int score(const Move& m) const
+    {
+        return scores_[index(m)];
+    }
+
+    /** Adds the bonus (which may be negative) to the move's score. */
+    void update(const Move& m, int bonus);
+
+    /** Halves every score, so that newer results count for more. */
+    void age();
+
+    /** Sets every score back to 0. */
+    void clear();
+
+  private:
+    /** Returns where the given move's score is kept. */
+    static int index(const Move& m)
+    {
+        return (m.color() * NUM_SQUARES + m.origin()) * NUM_SQUARES +
+               m.target();
+    }
+
+    /** The scores, indexed by index(). */
+    std::vector<int16_t> scores_;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef CHESS_MOVELIST_H
+#define CHESS_MOVELIST_H
+
+#include <cassert>
+#include <type_traits>
+
+#include "move.h"
+
+/**
+ * The most moves a list can hold, which no position can exceed. A side has
+ * at most 128 pieces (see MAX_PIECES), and a pawn about to promote has the
+ * most moves of any piece: a push and eight captures, each to any of the
+ * promotion pieces, or 99 in all. Only the 64 squares of one level hold such
+ * pawns, and the rest of the pieces have at most the queen's 85 moves, from
+ * the middle of the board. On top of that come the six castling moves.
+ */
+const int MAX_MOVES = 64 * 9 * NUM_PROMOTION_PIECES + 64 * 85 + 6;
+
+/**
+ * A fixed-capacity list of moves, meant to live on the stack. The move
+ * generators append to one of these instead of returning a std::list, so that
+ * generating moves never touches the heap.
+ */
+class MoveList
+{
+  public:
+    /** Constructs an empty list. */
+    MoveList() : size_(0)
+    {}
+
+
+    /** Appends a move to the end of the list. */
+    void push_back(const Move& m)
+    {
+        assert(size_ < MAX_MOVES);
+        data()[size_++] = m;
+    }
+
+    /** Shrinks the list to the given size, dropping moves off the end. */
+    void resize(int size)
+    {
+        assert(size <= size_);
+        size_ = size;
+    }
+
+    /** Removes all moves from the list. */
+    void clear()
+    {
+        size_ = 0;
+    }
+
+
+    /** Returns the number of moves in the list. */
+    int size() const
+    {
+        return size_;
+    }
+
+    /** Returns true if there are no moves in the list. */
+    bool empty() const
+    {
+        return size_ == 0;
+    }
+
+    /** Returns true if the given move is in the list. */
+    bool contains(const Move& m) const
+    {
+        for(const Move* it = begin(); it != end(); it++)
+            if(*it == m)
+                return true;
+        return false;
+    }
+
+
+    /** Element access. Undefined if i is out of range. */
+    Move& operator[](int i) { return data()[i]; }
+    const Move& operator[](int i) const { return data()[i]; }
+
+    /** Iterators, so that this can be walked like any other container. */
+    Move* begin() { return data(); }
+    Move* end() { return data() + size_; }
+    const Move* begin() const { return data(); }
+    const Move* end() const { return data() + size_; }
+
+  private:
+    /** Views the raw storage as an array of moves. */
+    Move* data() { return reinterpret_cast<Move*>(storage_); }
+    const Move* data() const { return reinterpret_cast<const Move*>(storage_); }
+
+    /** How many moves are in the list. */
+    int size_;
+
+    /**
+     * Uninitialized storage for the moves. A plain Move array would run
+     * Move's constructor on every slot each time a list is created.
+     */
+    std::aligned_storage<sizeof(Move), alignof(Move)>::type
+            storage_ [MAX_MOVES];
+};
+
+#endif
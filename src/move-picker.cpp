@@ -0,0 +1,201 @@
+#include "move-picker.h"
+
+#include <algorithm>
+
+/**
+ * Scores a capture by the value of the victim, and then by the value of the
+ * attacker, lowest first (MVV-LVA). A promo-capture also gains the value of
+ * the promotion. The attacker is worth at most 1600, so it never outweighs a
+ * difference in victims.
+ */
+static int captureScore(const Board& b, const Move& m)
+{
+    int victim = PIECE_VALUES[W_PAWN];
+    if(m.type() != EN_PASSANT)
+        victim = PIECE_VALUES[b.getPiece(m.target()).type()];
+    if(m.type() == PROMO_CAPTURE)
+        victim += PIECE_VALUES[m.promoted()] - PIECE_VALUES[W_PAWN];
+
+    int attacker = PIECE_VALUES[b.getPiece(m.origin()).type()];
+    return victim * 4096 - attacker;
+}
+
+MovePicker::MovePicker(const Board& board, const Move& hash_move,
+        const Move* killers, const History* history) :
+    board_(board), color_(board.whoseTurn()), captures_only_(false),
+    stage_(HASH_MOVE), history_(history), index_(0), bad_captures_(0)
+{
+    if(hash_move != Move() && hash_move.color() == color_ &&
+       board.isPseudoLegalMove(hash_move))
+        hash_move_ = hash_move;
+
+    // The killers are checked when their turn comes, since a cutoff might
+    // make that unnecessary
+    for(int i = 0; i < NUM_KILLERS; i++)
+        killers_[i] = (killers != NULL) ? killers[i] : Move();
+}
+
+MovePicker::MovePicker(const Board& board, const Move& hash_move) :
+    board_(board), color_(board.whoseTurn()), captures_only_(true),
+    stage_(HASH_MOVE), history_(NULL), index_(0), bad_captures_(0)
+{
+    if(hash_move.isCapture() && hash_move.color() == color_ &&
+       board.isPseudoLegalMove(hash_move))
+        hash_move_ = hash_move;
+}
+
+Move MovePicker::next()
+{
+    Move m;
+
+    // Each stage either hands out a move, or moves on to the next stage
+    while(true)
+    {
+        switch(stage_)
+        {
+          case HASH_MOVE:
+            stage_ = GENERATE_CAPTURES;
+            if(hash_move_ != Move())
+                return hash_move_;
+            break;
+
+          case GENERATE_CAPTURES:
+            board_.generateCaptures(color_, moves_);
+            std::sort(moves_.begin(), moves_.end(),
+                [this](const Move& a, const Move& b)
+                {
+                    return captureScore(board_, a) > captureScore(board_, b);
+                });
+            index_ = 0;
+            stage_ = CAPTURES;
+            break;
+
+          case CAPTURES:
+            for(m = nextFromList(); m != Move(); m = nextFromList())
+            {
+                if(!isLosingCapture(m))
+                    return m;
+
+                // Everything before index_ has been handed out, so there's
+                // room to keep the losing ones there, unless they're not
+                // wanted at all
+                if(!captures_only_)
+                    moves_[bad_captures_++] = m;
+            }
+            stage_ = captures_only_ ? DONE : GENERATE_PROMOTIONS;
+            break;
+
+          case GENERATE_PROMOTIONS:
+            moves_.resize(bad_captures_);
+            board_.generatePromotions(color_, moves_);
+            std::sort(moves_.begin() + bad_captures_, moves_.end(),
+                [](const Move& a, const Move& b)
+                {
+                    return PIECE_VALUES[a.promoted()] >
+                           PIECE_VALUES[b.promoted()];
+                });
+            index_ = bad_captures_;
+            stage_ = PROMOTIONS;
+            break;
+
+          case PROMOTIONS:
+            m = nextFromList();
+            if(m != Move())
+                return m;
+            index_ = 0;
+            stage_ = KILLERS;
+            break;
+
+          case KILLERS:
+            // Killers are quiet moves that caused a cutoff in a sibling
+            // position, so they may not even be possible here
+            while(index_ < NUM_KILLERS)
+            {
+                m = killers_[index_++];
+                if(m == Move() || !m.isQuiet() || m == hash_move_ ||
+                   !board_.isPseudoLegalMove(m))
+                    continue;
+
+                // The other killer might be the same move
+                bool repeated = false;
+                for(int i = 0; i < index_ - 1; i++)
+                    repeated |= (killers_[i] == m);
+                if(!repeated)
+                    return m;
+            }
+            stage_ = GENERATE_QUIETS;
+            break;
+
+          case GENERATE_QUIETS:
+            moves_.resize(bad_captures_);
+            board_.generateQuiets(color_, moves_);
+            if(history_ != NULL)
+            {
+                const History* history = history_;
+                std::stable_sort(moves_.begin() + bad_captures_, moves_.end(),
+                    [history](const Move& a, const Move& b)
+                    {
+                        return history->score(a) > history->score(b);
+                    });
+            }
+            index_ = bad_captures_;
+            stage_ = QUIETS;
+            break;
+
+          case QUIETS:
+            m = nextFromList();
+            if(m != Move())
+                return m;
+            index_ = 0;
+            stage_ = BAD_CAPTURES;
+            break;
+
+          case BAD_CAPTURES:
+            if(index_ < bad_captures_)
+                return moves_[index_++];
+            stage_ = DONE;
+            break;
+
+          case DONE:
+            return Move();
+        }
+    }
+}
+
+Move MovePicker::nextFromList()
+{
+    while(index_ < moves_.size())
+    {
+        Move m = moves_[index_++];
+        if(!isSpecial(m))
+            return m;
+    }
+
+    return Move();
+}
+
+bool MovePicker::isLosingCapture(const Move& m) const
+{
+    // Taking something at least as valuable can't lose, whatever comes next,
+    // and neither can en passant or a promotion
+    if(m.type() != CAPTURE)
+        return false;
+
+    int victim = PIECE_VALUES[board_.getPiece(m.target()).type()];
+    int attacker = PIECE_VALUES[board_.getPiece(m.origin()).type()];
+    return attacker > victim && board_.staticExchange(m) < 0;
+}
+
+bool MovePicker::isSpecial(const Move& m) const
+{
+    if(m == hash_move_)
+        return true;
+
+    // Killers are quiet, so there's no need to check for them before
+    if(stage_ == QUIETS)
+        for(int i = 0; i < NUM_KILLERS; i++)
+            if(m == killers_[i])
+                return true;
+
+    return false;
+}
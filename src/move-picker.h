@@ -0,0 +1,97 @@
+#ifndef CHESS_MOVEPICKER_H
+#define CHESS_MOVEPICKER_H
+
+#include "board.h"
+#include "history.h"
+#include "move.h"
+#include "move-list.h"
+
+/** How many killer moves the search remembers for each ply. */
+const int NUM_KILLERS = 2;
+
+/**
+ * Hands out the pseudo-legal moves of the side to move one at a time, best
+ * guesses first, for the search. Moves are only generated when they're
+ * needed, so a cutoff early on saves generating the (many) quiet moves.
+ *
+ * The order is: the hash move, captures (most valuable victim first, then
+ * least valuable attacker), promotions (best piece first), the killer moves,
+ * the other quiet moves, best history score first, and last of all the
+ * captures that lose material, by Board::staticExchange. No move is handed
+ * out twice. Legality is left to the caller, as with
+ * generatePseudoLegalMoves.
+ */
+class MovePicker
+{
+  public:
+    /**
+     * Constructs a picker over all moves. The hash move and the killers (an
+     * array of NUM_KILLERS) may come from other positions, or be nil, and are
+     * only used if they're pseudo-legal here. killers may also be NULL, and
+     * so may history, in which case the quiet moves aren't sorted.
+     */
+    MovePicker(const Board& board, const Move& hash_move, const Move* killers,
+            const History* history = NULL);
+
+    /**
+     * Constructs a picker over just the moves that capture, for quiescence
+     * search, leaving out the ones that lose material. The hash move is only
+     * used if it's one of them.
+     */
+    MovePicker(const Board& board, const Move& hash_move);
+
+    /** Returns the next move, or a nil move once there are none left. */
+    Move next();
+
+  private:
+    /** The stages of next, in order. */
+    enum Stage {
+        HASH_MOVE, GENERATE_CAPTURES, CAPTURES, GENERATE_PROMOTIONS,
+        PROMOTIONS, KILLERS, GENERATE_QUIETS, QUIETS, BAD_CAPTURES, DONE
+    };
+
+    /** Returns the next move in moves_ that hasn't been handed out yet. */
+    Move nextFromList();
+
+    /** Returns true if the move was handed out before moves_ was filled. */
+    bool isSpecial(const Move& m) const;
+
+    /**
+     * Returns true if the move is a capture that loses material once the
+     * other side takes back.
+     */
+    bool isLosingCapture(const Move& m) const;
+
+    /** The board the moves are for. It mustn't change while picking. */
+    const Board& board_;
+
+    /** The side to move. */
+    bool color_;
+
+    /** Whether to stop after the captures. */
+    bool captures_only_;
+
+    /** The stage that next is in. */
+    int stage_;
+
+    /** The hash move, or nil if there wasn't a usable one. */
+    Move hash_move_;
+
+    /** The killer moves, nil where there wasn't one. */
+    Move killers_ [NUM_KILLERS];
+
+    /** The scores to sort the quiet moves by, or NULL. */
+    const History* history_;
+
+    /** The moves of the current stage, and how many have been handed out. */
+    MoveList moves_;
+    int index_;
+
+    /**
+     * How many losing captures have been put off. They're kept at the start
+     * of moves_, and the later stages' moves go after them.
+     */
+    int bad_captures_;
+};
+
+#endif
@@ -45,6 +45,30 @@ PieceType Move::promoted() const
     return static_cast<PieceType>((data_ >> 26) & 0xF);
 }
 
+bool Move::isCapture() const
+{
+    MoveType t = type();
+    return t == CAPTURE || t == EN_PASSANT || t == PROMO_CAPTURE;
+}
+
+bool Move::isQuiet() const
+{
+    MoveType t = type();
+    return t == QUIET || t == DOUBLE_PAWN_PUSH || t == CASTLE;
+}
+
+unsigned int Move::bits() const
+{
+    return data_;
+}
+
+Move Move::fromBits(unsigned int bits)
+{
+    Move m;
+    m.data_ = bits;
+    return m;
+}
+
 bool Move::operator==(const Move& m) const
 {
     return (data_ == m.data_);
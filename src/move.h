@@ -62,6 +62,23 @@ class Move
      */
     PieceType promoted() const;
 
+    /** Returns true if this move takes a piece, en passant included. */
+    bool isCapture() const;
+
+    /** Returns true if this move neither takes a piece nor promotes. */
+    bool isQuiet() const;
+
+
+    /**
+     * Returns the move packed into 32 bits, for tables that store moves
+     * outside of a Move. Two squares out of 512 each take 9 bits, so a move
+     * can't be packed any smaller than about 3 bytes.
+     */
+    unsigned int bits() const;
+
+    /** Returns the move that bits() was called on. */
+    static Move fromBits(unsigned int bits);
+
 
     /** Operators */
     bool operator==(const Move& m) const;
@@ -74,7 +91,7 @@ class Move
      *   Bit  3    - color
      *   Bits 4-14 - origin
      *   Bits 15-25 - target
-     *   Bits 26-28 - promoted type
+     *   Bits 26-29 - promoted type
      */
     unsigned int data_;
 };
@@ -0,0 +1,323 @@
+#include "nnue.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CHESS_HAVE_AVX2_KERNELS
+#endif
+
+/** The file format's magic number and version. */
+static const char MAGIC [4] = { '3', 'D', 'N', 'N' };
+static const uint32_t VERSION = 1;
+
+/** The network in use, and every network loaded, which are never freed. */
+static const Network* active = NULL;
+static std::vector<std::unique_ptr<Network> > loaded;
+
+/** Whether the AVX2 kernels are in use. */
+static bool use_simd = setSimd(true);
+
+Network::Network() :
+    feature_weights((size_t) NNUE_FEATURES * NNUE_HIDDEN, 0), output_bias(0)
+{
+    std::fill(feature_biases, feature_biases + NNUE_HIDDEN, 0);
+    std::fill(output_weights, output_weights + 2 * NNUE_HIDDEN, 0);
+}
+
+/** Reads or writes a little-endian uint32. */
+static bool readU32(FILE* f, uint32_t* x)
+{
+    unsigned char b [4];
+    if(fread(b, 1, 4, f) != 4)
+        return false;
+    *x = b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t) b[3] << 24);
+    return true;
+}
+
+static bool writeU32(FILE* f, uint32_t x)
+{
+    unsigned char b [4] = {
+        (unsigned char) x, (unsigned char) (x >> 8),
+        (unsigned char) (x >> 16), (unsigned char) (x >> 24)
+    };
+    return fwrite(b, 1, 4, f) == 4;
+}
+
+/** Reads or writes an array of little-endian int16s. */
+static bool readI16(FILE* f, int16_t* x, size_t n)
+{
+    std::vector<unsigned char> b (2 * n);
+    if(fread(b.data(), 1, b.size(), f) != b.size())
+        return false;
+    for(size_t i = 0; i < n; i++)
+        x[i] = (int16_t) (b[2 * i] | (b[2 * i + 1] << 8));
+    return true;
+}
+
+static bool writeI16(FILE* f, const int16_t* x, size_t n)
+{
+    std::vector<unsigned char> b (2 * n);
+    for(size_t i = 0; i < n; i++)
+    {
+        b[2 * i] = (unsigned char) x[i];
+        b[2 * i + 1] = (unsigned char) ((uint16_t) x[i] >> 8);
+    }
+    return fwrite(b.data(), 1, b.size(), f) == b.size();
+}
+
+bool Network::load(const std::string& path)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if(f == NULL)
+        return false;
+
+    // Read into a scratch network, so that a bad file changes nothing
+    std::unique_ptr<Network> net (new Network());
+    char magic [4];
+    uint32_t version, hidden, features, bias;
+    bool ok = fread(magic, 1, 4, f) == 4 &&
+              memcmp(magic, MAGIC, 4) == 0 &&
+              readU32(f, &version) && version == VERSION &&
+              readU32(f, &hidden) && hidden == NNUE_HIDDEN &&
+              readU32(f, &features) && features == NNUE_FEATURES &&
+              readI16(f, net->feature_weights.data(),
+                      net->feature_weights.size()) &&
+              readI16(f, net->feature_biases, NNUE_HIDDEN) &&
+              fread(net->output_weights, 1, 2 * NNUE_HIDDEN, f) ==
+                      2 * NNUE_HIDDEN &&
+              readU32(f, &bias) &&
+              fgetc(f) == EOF;
+    fclose(f);
+
+    if(!ok)
+        return false;
+
+    net->output_bias = (int32_t) bias;
+    *this = *net;
+    return true;
+}
+
+bool Network::save(const std::string& path) const
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    if(f == NULL)
+        return false;
+
+    bool ok = fwrite(MAGIC, 1, 4, f) == 4 &&
+              writeU32(f, VERSION) &&
+              writeU32(f, NNUE_HIDDEN) &&
+              writeU32(f, NNUE_FEATURES) &&
+              writeI16(f, feature_weights.data(), feature_weights.size()) &&
+              writeI16(f, feature_biases, NNUE_HIDDEN) &&
+              fwrite(output_weights, 1, 2 * NNUE_HIDDEN, f) ==
+                      2 * NNUE_HIDDEN &&
+              writeU32(f, (uint32_t) output_bias);
+    return (fclose(f) == 0) && ok;
+}
+
+int Network::kingBucket(bool side, int king_sq)
+{
+    if(king_sq < 0)
+        return 0;
+
+    // Black sees the levels flipped
+    int z = squareZ(king_sq);
+    if(side == BLACK)
+        z = 7 - z;
+
+    return (squareX(king_sq) >= 4) + 2 * (squareY(king_sq) >= 4) +
+           4 * (z >= 4);
+}
+
+int Network::feature(bool side, const Piece& p, int square, int king_sq)
+{
+    if(side == BLACK)
+    {
+        square = squareAt(squareX(square), squareY(square),
+                          7 - squareZ(square));
+    }
+
+    // Pawns are kind 0, and the rest follow in PieceType order
+    PieceType pt = p.type();
+    int kind = (pt == W_PAWN || pt == B_PAWN) ? 0 : pt - B_PAWN;
+    if(p.color() != side)
+        kind += NNUE_PIECE_KINDS;
+
+    int bucket = kingBucket(side, king_sq);
+    return (bucket * 2 * NNUE_PIECE_KINDS + kind) * NUM_SQUARES + square;
+}
+
+Accumulator::Accumulator() : network(NULL)
+{
+    dirty[WHITE] = dirty[BLACK] = true;
+}
+
+const Network* activeNetwork()
+{
+    return active;
+}
+
+bool loadNetwork(const std::string& path)
+{
+    std::unique_ptr<Network> net (new Network());
+    if(!net->load(path))
+        return false;
+
+    // Boards may still point at the old network, so it's kept
+    active = net.get();
+    loaded.push_back(std::move(net));
+    return true;
+}
+
+void setActiveNetwork(const Network* network)
+{
+    active = network;
+}
+
+//----KERNELS----
+
+/*
+ * The scalar kernels say what the AVX2 ones compute. Both wrap around on
+ * int16 overflow, so they always agree.
+ */
+
+static void addScalar(int16_t* values, const int16_t* column)
+{
+    for(int i = 0; i < NNUE_HIDDEN; i++)
+        values[i] = (int16_t) (values[i] + column[i]);
+}
+
+static void subtractScalar(int16_t* values, const int16_t* column)
+{
+    for(int i = 0; i < NNUE_HIDDEN; i++)
+        values[i] = (int16_t) (values[i] - column[i]);
+}
+
+/** Returns the dot product of the clipped values with the weights. */
+static int32_t dotScalar(const int16_t* values, const int8_t* weights)
+{
+    int32_t sum = 0;
+    for(int i = 0; i < NNUE_HIDDEN; i++)
+    {
+        int v = std::min(std::max((int) values[i], 0), NNUE_QA);
+        sum += v * weights[i];
+    }
+    return sum;
+}
+
+#ifdef CHESS_HAVE_AVX2_KERNELS
+
+__attribute__((target("avx2")))
+static void addAvx2(int16_t* values, const int16_t* column)
+{
+    for(int i = 0; i < NNUE_HIDDEN; i += 16)
+    {
+        __m256i* v = (__m256i*) (values + i);
+        __m256i c = _mm256_loadu_si256((const __m256i*) (column + i));
+        _mm256_storeu_si256(v, _mm256_add_epi16(_mm256_loadu_si256(v), c));
+    }
+}
+
+__attribute__((target("avx2")))
+static void subtractAvx2(int16_t* values, const int16_t* column)
+{
+    for(int i = 0; i < NNUE_HIDDEN; i += 16)
+    {
+        __m256i* v = (__m256i*) (values + i);
+        __m256i c = _mm256_loadu_si256((const __m256i*) (column + i));
+        _mm256_storeu_si256(v, _mm256_sub_epi16(_mm256_loadu_si256(v), c));
+    }
+}
+
+__attribute__((target("avx2")))
+static int32_t dotAvx2(const int16_t* values, const int8_t* weights)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i qa = _mm256_set1_epi16(NNUE_QA);
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = zero;
+
+    for(int i = 0; i < NNUE_HIDDEN; i += 32)
+    {
+        // Clip 32 values and pack them into bytes. Packing works within each
+        // 128-bit lane, so the quarters have to be put back in order.
+        __m256i a = _mm256_loadu_si256((const __m256i*) (values + i));
+        __m256i b = _mm256_loadu_si256((const __m256i*) (values + i + 16));
+        a = _mm256_min_epi16(_mm256_max_epi16(a, zero), qa);
+        b = _mm256_min_epi16(_mm256_max_epi16(b, zero), qa);
+        __m256i packed = _mm256_permute4x64_epi64(
+                _mm256_packus_epi16(a, b), 0xD8);
+
+        // Unsigned bytes times signed bytes, summed in pairs, which can't
+        // overflow since the values are at most 127, and then in fours
+        __m256i w = _mm256_loadu_si256((const __m256i*) (weights + i));
+        __m256i products = _mm256_maddubs_epi16(packed, w);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+    }
+
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                                 _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    return _mm_cvtsi128_si32(half);
+}
+
+#endif
+
+bool setSimd(bool enabled)
+{
+#ifdef CHESS_HAVE_AVX2_KERNELS
+    use_simd = enabled && __builtin_cpu_supports("avx2");
+#else
+    use_simd = false;
+#endif
+    return use_simd;
+}
+
+void addFeature(const Network& network, int16_t* values, int feature)
+{
+    const int16_t* column = &network.feature_weights[(size_t) feature *
+            NNUE_HIDDEN];
+#ifdef CHESS_HAVE_AVX2_KERNELS
+    if(use_simd)
+        return addAvx2(values, column);
+#endif
+    addScalar(values, column);
+}
+
+void subtractFeature(const Network& network, int16_t* values, int feature)
+{
+    const int16_t* column = &network.feature_weights[(size_t) feature *
+            NNUE_HIDDEN];
+#ifdef CHESS_HAVE_AVX2_KERNELS
+    if(use_simd)
+        return subtractAvx2(values, column);
+#endif
+    subtractScalar(values, column);
+}
+
+int evaluateNetwork(const Network& network, const Accumulator& accumulator,
+        bool side_to_move)
+{
+    const int16_t* ours = accumulator.values[side_to_move];
+    const int16_t* theirs = accumulator.values[!side_to_move];
+    const int8_t* weights = network.output_weights;
+
+    int32_t sum;
+#ifdef CHESS_HAVE_AVX2_KERNELS
+    if(use_simd)
+        sum = dotAvx2(ours, weights) + dotAvx2(theirs, weights + NNUE_HIDDEN);
+    else
+#endif
+        sum = dotScalar(ours, weights) +
+              dotScalar(theirs, weights + NNUE_HIDDEN);
+
+    int64_t out = (int64_t) sum + network.output_bias;
+    out = out * NNUE_SCALE / (NNUE_QA * NNUE_QB);
+    return (int) std::min<int64_t>(std::max<int64_t>(out, -NNUE_MAX_SCORE),
+                                   NNUE_MAX_SCORE);
+}
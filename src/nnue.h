@@ -0,0 +1,156 @@
+#ifndef CHESS_NNUE_H
+#define CHESS_NNUE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "piece.h"
+
+/**
+ * The king buckets: each king's half of the network's input depends on which
+ * of the board's eight octants (2 x 2 x 2 blocks of 4 x 4 x 4 squares) the
+ * king stands in, as seen from its own side.
+ */
+const int NNUE_KING_BUCKETS = 8;
+
+/**
+ * The kinds of pieces the network tells apart, for each side: pawns (either
+ * color), the eleven other pieces, and the king.
+ */
+const int NNUE_PIECE_KINDS = 13;
+
+/** The number of input features: a king bucket, a piece and a square. */
+const int NNUE_FEATURES = NNUE_KING_BUCKETS * 2 * NNUE_PIECE_KINDS *
+        NUM_SQUARES;
+
+/** The size of each side's half of the hidden layer. */
+const int NNUE_HIDDEN = 128;
+
+/**
+ * The network's scales. Hidden values are clipped to [0, NNUE_QA] and the
+ * output weights are fixed point with NNUE_QB as 1, so the output comes out
+ * NNUE_QA * NNUE_QB times too large; that's then scaled to hundredths of a
+ * pawn by NNUE_SCALE.
+ */
+const int NNUE_QA = 127;
+const int NNUE_QB = 64;
+const int NNUE_SCALE = 400;
+
+/**
+ * The furthest from 0 the network's score can be. A network can say far more
+ * than this, but the search takes scores past MATE_BOUND for mates, and keeps
+ * scores in 16 bits, so they're clamped well short of either.
+ */
+const int NNUE_MAX_SCORE = 20000;
+
+/**
+ * A small efficiently updatable neural network (NNUE) evaluation. The input
+ * is one feature for each piece on the board, from each side's point of
+ * view: the side's king bucket, the piece (whether it's the side's own or
+ * the other's, and its kind) and its square. Black sees the board with the
+ * levels flipped, as it is shown from Black's side, so that both sides see
+ * their own pieces start on the bottom.
+ *
+ * Each side's features are summed into an accumulator of NNUE_HIDDEN int16
+ * values, which Board keeps up to date as pieces move: a move only adds and
+ * subtracts a few columns of weights. The side to move's accumulator and the
+ * other one are clipped to [0, NNUE_QA], and their dot product with the int8
+ * output weights, plus the bias, is the score. On CPUs with AVX2, the sums
+ * are done 16 or 32 values at a time.
+ *
+ * Networks are read from a binary file, little-endian: the magic "3DNN", a
+ * version (1), NNUE_HIDDEN and NNUE_FEATURES as uint32; then the int16
+ * feature weights, feature by feature, the int16 biases, the int8 output
+ * weights (side to move first), and the int32 output bias.
+ */
+class Network
+{
+  public:
+    /** Constructs a network with every weight 0. */
+    Network();
+
+    /** Reads the network from a file. Returns false if it can't. */
+    bool load(const std::string& path);
+
+    /** Writes the network to a file. Returns false if it can't. */
+    bool save(const std::string& path) const;
+
+    /**
+     * Returns the index of the feature for piece p on square, from the point
+     * of view of the given side, whose king is on king_sq (or a negative
+     * number, if it has no king).
+     */
+    static int feature(bool side, const Piece& p, int square, int king_sq);
+
+    /** Returns the king bucket of the given side's king square. */
+    static int kingBucket(bool side, int king_sq);
+
+    /** The weights, indexed by feature and then by hidden value. */
+    std::vector<int16_t> feature_weights;
+    int16_t feature_biases [NNUE_HIDDEN];
+
+    /** The output weights, for the side to move's half and then the other. */
+    int8_t output_weights [2 * NNUE_HIDDEN];
+    int32_t output_bias;
+};
+
+/**
+ * Each side's half of the hidden layer, for some position. It's only good for
+ * the network it was computed with, and a side's half is dirty when it has
+ * to be computed from scratch (when that side's king has changed buckets).
+ */
+struct Accumulator
+{
+    /** Constructs an accumulator for no network. */
+    Accumulator();
+
+    /** The network the values are for, or NULL. */
+    const Network* network;
+
+    /** The values, indexed by side. */
+    int16_t values [2][NNUE_HIDDEN];
+
+    /** Whether each side's values have to be computed from scratch. */
+    bool dirty [2];
+};
+
+/** Returns the network in use, or NULL if the evaluation is handcrafted. */
+const Network* activeNetwork();
+
+/**
+ * Reads a network from the file and starts using it. If it can't be read,
+ * this returns false, and the evaluation stays as it was. This mustn't be
+ * called while a search is running.
+ */
+bool loadNetwork(const std::string& path);
+
+/**
+ * Makes the given network (or NULL, for the handcrafted evaluation) active.
+ * The caller keeps ownership, and the network has to outlive every board
+ * evaluated with it.
+ */
+void setActiveNetwork(const Network* network);
+
+/** Adds the column of weights of the given feature to the values. */
+void addFeature(const Network& network, int16_t* values, int feature);
+
+/** Subtracts the column of weights of the given feature from the values. */
+void subtractFeature(const Network& network, int16_t* values, int feature);
+
+/**
+ * Returns the network's score, in hundredths of a pawn, for the side to move,
+ * given the accumulator of the position. It's clamped to NNUE_MAX_SCORE.
+ */
+int evaluateNetwork(const Network& network, const Accumulator& accumulator,
+        bool side_to_move);
+
+/**
+ * Whether to use the AVX2 kernels, which give the same results as the
+ * scalar ones. It's on by default if the CPU has AVX2, and can't be turned
+ * on if it doesn't. Returns whether it's on.
+ */
+bool setSimd(bool enabled);
+
+#endif
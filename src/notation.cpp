@@ -0,0 +1,83 @@
+#include "notation.h"
+
+#include <cctype>
+
+#include "common.h"
+
+/** The letter for each PieceType, in upper case. */
+static const char PIECE_LETTERS [16] = {
+    ' ', ' ', 'P', 'P',
+    'N', 'G', 'D', 'U',
+    'R', 'B', 'M',
+    'W', 'A', 'C',
+    'Q', 'K'
+};
+
+std::string squareName(int square)
+{
+    std::string name;
+    name += (char) ('a' + squareX(square));
+    name += (char) ('1' + squareY(square));
+    name += (char) ('A' + squareZ(square));
+    return name;
+}
+
+int parseSquare(const std::string& name)
+{
+    if(name.size() != 3)
+        return -1;
+
+    int x = name[0] - 'a';
+    int y = name[1] - '1';
+    int z = name[2] - 'A';
+
+    if(x < 0 || x > 7 || y < 0 || y > 7 || z < 0 || z > 7)
+        return -1;
+
+    return squareAt(x, y, z);
+}
+
+char pieceLetter(const Piece& p)
+{
+    char c = PIECE_LETTERS[p.type()];
+    return (p.color() == BLACK) ? tolower(c) : c;
+}
+
+Piece parsePieceLetter(char c)
+{
+    bool color = islower(c) ? BLACK : WHITE;
+    char upper = toupper(c);
+
+    if(upper == 'P')
+        return Piece::Pawn(color);
+
+    for(int pt = KNIGHT; pt <= KING; pt++)
+        if(PIECE_LETTERS[pt] == upper)
+            return Piece((PieceType) pt, color);
+
+    return Piece(NIL, WHITE);
+}
+
+std::string moveName(const Move& m)
+{
+    std::string name = squareName(m.origin()) + "-" + squareName(m.target());
+
+    if(m.type() == PROMOTE || m.type() == PROMO_CAPTURE)
+    {
+        name += '=';
+        name += PIECE_LETTERS[m.promoted()];
+    }
+
+    return name;
+}
+
+Move parseMove(const Board& board, const std::string& name)
+{
+    MoveList moves;
+    board.generateLegalMoves(board.whoseTurn(), moves);
+    for(const Move* it = moves.begin(); it != moves.end(); it++)
+        if(moveName(*it) == name)
+            return *it;
+
+    return Move();
+}
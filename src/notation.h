@@ -0,0 +1,45 @@
+#ifndef CHESS_NOTATION_H
+#define CHESS_NOTATION_H
+
+#include <string>
+
+#include "board.h"
+#include "move.h"
+#include "piece.h"
+
+/*
+ * Text forms of squares, pieces and moves, for the command-line tools.
+ *
+ * A square is written as its file (x, a to h), its rank (y, 1 to 8) and its
+ * level (z, A to H), so the white king starts on e5A. A piece is a letter:
+ * P(awn), N(knight), G(riffin), D(ragon), U(nicorn), R(ook), B(ishop),
+ * M(ace), W(izard), A(rcher), C(annon), Q(ueen) and K(ing), in upper case
+ * for White and lower case for Black. A move is its origin and target, with
+ * the promoted piece after an '=', like e5G-e5H=Q.
+ */
+
+/** Returns the name of the given square. */
+std::string squareName(int square);
+
+/** Returns the square with the given name, or -1 if it isn't one. */
+int parseSquare(const std::string& name);
+
+/** Returns the letter for the given piece, or ' ' for an empty square. */
+char pieceLetter(const Piece& p);
+
+/**
+ * Returns the piece with the given letter, or an empty one (NIL) if it isn't
+ * one. Pawns come back as Piece::Pawn of the letter's color.
+ */
+Piece parsePieceLetter(char c);
+
+/** Returns the text form of the given move. */
+std::string moveName(const Move& m);
+
+/**
+ * Returns the legal move on the board, for the side to move, with the given
+ * text form, or a nil move if there isn't one.
+ */
+Move parseMove(const Board& board, const std::string& name);
+
+#endif
@@ -0,0 +1,214 @@
+#include "opening-book.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/** The file's header, ahead of the entries. */
+struct BookHeader
+{
+    char magic [4];
+    uint32_t version;
+    uint64_t num_entries;
+};
+
+static const char MAGIC [4] = { '3', 'D', 'B', 'K' };
+static const uint32_t VERSION = 1;
+
+static_assert(sizeof(BookHeader) == 16, "the header is 16 bytes");
+static_assert(sizeof(BookEntry) == 16, "an entry is 16 bytes");
+
+/** Orders entries by key, and then by weight, highest first. */
+static bool entryLess(const BookEntry& a, const BookEntry& b)
+{
+    if(a.key != b.key)
+        return a.key < b.key;
+    return a.weight > b.weight;
+}
+
+/** Orders entries by key alone, for searching. */
+static bool keyLess(const BookEntry& e, uint64_t key)
+{
+    return e.key < key;
+}
+
+OpeningBook::OpeningBook() : mapping_(NULL), mapping_size_(0),
+    entries_(NULL), num_entries_(0)
+{
+}
+
+OpeningBook::~OpeningBook()
+{
+    close();
+}
+
+bool OpeningBook::open(const std::string& path)
+{
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(BookHeader))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // The mapping outlives the descriptor
+    size_t size = st.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if(mapping == MAP_FAILED)
+        return false;
+
+    const BookHeader* header = (const BookHeader*) mapping;
+    size_t body = size - sizeof(BookHeader);
+    if(memcmp(header->magic, MAGIC, 4) != 0 || header->version != VERSION ||
+       body % sizeof(BookEntry) != 0 ||
+       header->num_entries != body / sizeof(BookEntry))
+    {
+        munmap(mapping, size);
+        return false;
+    }
+
+    mapping_ = mapping;
+    mapping_size_ = size;
+    entries_ = (const BookEntry*) (header + 1);
+    num_entries_ = header->num_entries;
+    return true;
+}
+
+void OpeningBook::close()
+{
+    if(mapping_ != NULL)
+        munmap(mapping_, mapping_size_);
+
+    mapping_ = NULL;
+    mapping_size_ = 0;
+    entries_ = NULL;
+    num_entries_ = 0;
+}
+
+size_t OpeningBook::size() const
+{
+    return num_entries_;
+}
+
+void OpeningBook::probe(uint64_t key, const BookEntry** begin,
+        const BookEntry** end) const
+{
+    const BookEntry* last = entries_ + num_entries_;
+    const BookEntry* first = std::lower_bound(entries_, last, key, keyLess);
+
+    *begin = first;
+    while(first != last && first->key == key)
+        first++;
+    *end = first;
+}
+
+Move OpeningBook::pickMove(const Board& board, uint64_t random) const
+{
+    const BookEntry* begin;
+    const BookEntry* end;
+    probe(board.hash(), &begin, &end);
+
+    MoveList legal;
+    if(begin != end)
+        board.generateLegalMoves(board.whoseTurn(), legal);
+
+    // Weigh up the legal moves, and then pick one by the random number
+    uint64_t total = 0;
+    std::vector<std::pair<Move, uint64_t> > candidates;
+    for(const BookEntry* e = begin; e != end; e++)
+    {
+        Move m = Move::fromBits(e->move);
+        uint64_t weight = (uint64_t) e->weight * (e->learn + 100);
+        if(weight > 0 && legal.contains(m))
+        {
+            candidates.push_back(std::make_pair(m, weight));
+            total += weight;
+        }
+    }
+
+    if(total == 0)
+        return Move();
+
+    uint64_t pick = random % total;
+    for(size_t i = 0; i < candidates.size(); i++)
+    {
+        if(pick < candidates[i].second)
+            return candidates[i].first;
+        pick -= candidates[i].second;
+    }
+
+    return Move();
+}
+
+void BookBuilder::add(uint64_t key, const Move& m, double result)
+{
+    Stats& stats = moves_[std::make_pair(key, (uint32_t) m.bits())];
+    stats.count++;
+    stats.score += result;
+}
+
+void BookBuilder::merge(const BookBuilder& other)
+{
+    std::map<std::pair<uint64_t, uint32_t>, Stats>::const_iterator it;
+    for(it = other.moves_.begin(); it != other.moves_.end(); ++it)
+    {
+        Stats& stats = moves_[it->first];
+        stats.count += it->second.count;
+        stats.score += it->second.score;
+    }
+}
+
+size_t BookBuilder::size() const
+{
+    return moves_.size();
+}
+
+bool BookBuilder::write(const std::string& path, int min_count) const
+{
+    std::vector<BookEntry> entries;
+    std::map<std::pair<uint64_t, uint32_t>, Stats>::const_iterator it;
+    for(it = moves_.begin(); it != moves_.end(); ++it)
+    {
+        const Stats& stats = it->second;
+        if(stats.count < (uint32_t) std::max(min_count, 1))
+            continue;
+
+        BookEntry e;
+        e.key = it->first.first;
+        e.move = it->first.second;
+        e.weight = (uint16_t) std::min<uint32_t>(stats.count, 65535);
+        e.learn = (int16_t) lround(100 * (2 * stats.score / stats.count - 1));
+        entries.push_back(e);
+    }
+
+    // The map is in order of key already, but not of weight
+    std::sort(entries.begin(), entries.end(), entryLess);
+
+    BookHeader header;
+    memcpy(header.magic, MAGIC, 4);
+    header.version = VERSION;
+    header.num_entries = entries.size();
+
+    FILE* f = fopen(path.c_str(), "wb");
+    if(f == NULL)
+        return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(entries.data(), sizeof(BookEntry), entries.size(), f) ==
+                      entries.size();
+    return (fclose(f) == 0) && ok;
+}
@@ -0,0 +1,143 @@
+#ifndef CHESS_OPENINGBOOK_H
+#define CHESS_OPENINGBOOK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "board.h"
+#include "move.h"
+
+/**
+ * One entry of an opening book: a move that was played in a position. The
+ * move is Move::bits, since a move doesn't fit in fewer than 32 bits here,
+ * which keeps an entry at 16 bytes.
+ */
+struct BookEntry
+{
+    /** The Zobrist hash of the position (see Board::hash). */
+    uint64_t key;
+
+    /** The move, as Move::bits. */
+    uint32_t move;
+
+    /** How often the move was played, up to 65535. */
+    uint16_t weight;
+
+    /**
+     * How well the move did for the side that played it, from -100 (it
+     * always lost) to 100 (it always won).
+     */
+    int16_t learn;
+};
+
+/**
+ * An opening book, read straight from a file with mmap: there's nothing to
+ * parse when it's opened, and processes opening the same book share its
+ * pages. Probing is a binary search, so it takes well under a microsecond,
+ * and only touches the pages it needs.
+ *
+ * The file is a header of 16 bytes (the magic "3DBK", the version, 1, as a
+ * uint32, and the number of entries as a uint64), then the BookEntries, sorted
+ * by key and then by weight, highest first. Everything is in the byte order
+ * of the machine that wrote it, which is little-endian on every machine this
+ * builds on; a file from a machine of the other order has the wrong version,
+ * and won't open.
+ */
+class OpeningBook
+{
+  public:
+    /** Constructs a book with no entries. */
+    OpeningBook();
+
+    /** Closes the book. */
+    ~OpeningBook();
+
+    /**
+     * Maps the book in the given file, closing the one that was open. Returns
+     * false, leaving the book empty, if the file can't be mapped or isn't a
+     * book.
+     */
+    bool open(const std::string& path);
+
+    /** Unmaps the book, leaving it empty. */
+    void close();
+
+    /** Returns how many entries the book has. */
+    size_t size() const;
+
+    /**
+     * Returns the entries for the position with the given hash, highest
+     * weight first, as the range [*begin, *end), which is empty if there
+     * aren't any.
+     */
+    void probe(uint64_t key, const BookEntry** begin,
+            const BookEntry** end) const;
+
+    /**
+     * Picks one of the book's moves for the side to move, at random by the
+     * given number, in proportion to weight * (learn + 100): moves played more
+     * often, and that did better, come up more. Returns a nil move if the
+     * position isn't in the book, or none of its moves are legal (as they may
+     * not be, if another position has the same hash).
+     */
+    Move pickMove(const Board& board, uint64_t random) const;
+
+  private:
+    /** Books can't be copied, since the mapping would be unmapped twice. */
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook& operator=(const OpeningBook&) = delete;
+
+    /** The mapping, and how long it is, or NULL and 0 if there's no book. */
+    void* mapping_;
+    size_t mapping_size_;
+
+    /** The entries, within the mapping. */
+    const BookEntry* entries_;
+    size_t num_entries_;
+};
+
+/**
+ * Collects the moves of games, to make a book of. Each builder is meant for
+ * one thread; builders from several threads are then merged into one.
+ */
+class BookBuilder
+{
+  public:
+    /**
+     * Adds that the given move was played in the position with the given
+     * hash, and that the side that played it went on to score result (1 for
+     * a win, 0.5 for a draw, 0 for a loss).
+     */
+    void add(uint64_t key, const Move& m, double result);
+
+    /** Adds everything the other builder has collected to this one. */
+    void merge(const BookBuilder& other);
+
+    /** Returns how many different moves, in different positions, there are. */
+    size_t size() const;
+
+    /**
+     * Writes the moves played at least min_count times as a book. Returns
+     * false if the file can't be written.
+     */
+    bool write(const std::string& path, int min_count) const;
+
+  private:
+    /** How often a move was played, and the total result of playing it. */
+    struct Stats
+    {
+        Stats() : count(0), score(0)
+        {}
+
+        uint32_t count;
+        double score;
+    };
+
+    /** The stats of each move, keyed by hash and then Move::bits. */
+    std::map<std::pair<uint64_t, uint32_t>, Stats> moves_;
+};
+
+#endif
@@ -0,0 +1,165 @@
+#include "pawn-table.h"
+
+#include "eval-params.h"
+#include "geometry.h"
+
+/** How many entries a PawnTable has. This has to be a power of two. */
+static const size_t NUM_ENTRIES = 1 << 13;
+
+/** The sets of squares that the pawn evaluation looks at, for each pawn. */
+struct PawnMasks
+{
+    /** Fills in the masks. */
+    PawnMasks();
+
+    /** The squares of each file, indexed by x + 8 * y. */
+    Bitboard file [64];
+
+    /** The squares of the neighbouring files, indexed as file. */
+    Bitboard neighbours [64];
+
+    /**
+     * Indexed by color and square: the squares ahead of a pawn on its own
+     * file and the neighbouring files, where an enemy pawn would stop it
+     * from being passed.
+     */
+    Bitboard passed [2][NUM_SQUARES];
+
+    /**
+     * Indexed by color and square: the squares on the neighbouring files
+     * level with a pawn or behind it, from where a pawn could defend it.
+     */
+    Bitboard support [2][NUM_SQUARES];
+};
+
+PawnMasks::PawnMasks()
+{
+    for(int f = 0; f < 64; f++)
+    {
+        int x = f % 8, y = f / 8;
+        for(int z = 0; z < 8; z++)
+            file[f].set(squareAt(x, y, z));
+    }
+
+    for(int f = 0; f < 64; f++)
+    {
+        int x = f % 8, y = f / 8;
+        for(int dx = -1; dx <= 1; dx++)
+        {
+            for(int dy = -1; dy <= 1; dy++)
+            {
+                int nx = x + dx, ny = y + dy;
+                if((dx != 0 || dy != 0) && nx >= 0 && nx < 8 && ny >= 0 &&
+                   ny < 8)
+                    neighbours[f] |= file[nx + 8 * ny];
+            }
+        }
+    }
+
+    for(int sq = 0; sq < NUM_SQUARES; sq++)
+    {
+        int f = squareX(sq) + 8 * squareY(sq);
+        int z = squareZ(sq);
+        Bitboard near = file[f] | neighbours[f];
+
+        // White moves up, and Black down
+        for(int other = 0; other < 8; other++)
+        {
+            Bitboard level = Bitboard::level(other);
+            if(other > z)
+                passed[WHITE][sq] |= near & level;
+            if(other < z)
+                passed[BLACK][sq] |= near & level;
+            if(other <= z)
+                support[WHITE][sq] |= neighbours[f] & level;
+            if(other >= z)
+                support[BLACK][sq] |= neighbours[f] & level;
+        }
+    }
+}
+
+/** The masks themselves, computed at startup. */
+static const PawnMasks MASKS;
+
+void evaluatePawns(const Board& board, PawnEntry& entry, EvalTrace* trace)
+{
+    const EvalParams& params = evalParams();
+    entry.key = board.pawnHash();
+    entry.score = Score();
+
+    for(int color = 0; color < 2; color++)
+    {
+
+        PieceType pt = Piece::Pawn(color).type();
+        PieceType enemy_pt = Piece::Pawn(!color).type();
+        Bitboard ours = board.pieces(color, pt);
+        Bitboard theirs = board.pieces(!color, enemy_pt);
+
+        Score score;
+        entry.passed[color] = Bitboard();
+
+        Bitboard left = ours;
+        while(!left.empty())
+        {
+            int sq = left.popLowest();
+            int f = squareX(sq) + 8 * squareY(sq);
+            int z = squareZ(sq);
+            int rank = (color == WHITE) ? z : 7 - z;
+
+            // The EvalParams this pawn earns
+            int terms [3];
+            int num_terms = 0;
+
+            if((theirs & MASKS.passed[color][sq]).empty())
+            {
+                entry.passed[color].set(sq);
+                terms[num_terms++] = PASSED + rank;
+            }
+
+            if(!(ours & MASKS.passed[color][sq] & MASKS.file[f]).empty())
+                terms[num_terms++] = DOUBLED;
+
+            if((ours & MASKS.neighbours[f]).empty())
+                terms[num_terms++] = ISOLATED;
+            else if((ours & MASKS.support[color][sq]).empty())
+            {
+                // Is the square in front attacked? An enemy pawn attacks it
+                // iff one of ours on it would attack the enemy pawn.
+                int stop = sq + ((color == WHITE) ? 64 : -64);
+                if(stop >= 0 && stop < NUM_SQUARES &&
+                   !(Geometry::leaps(pt, stop) & theirs).empty())
+                    terms[num_terms++] = BACKWARD;
+            }
+
+            for(int i = 0; i < num_terms; i++)
+            {
+                score += params.scores[terms[i]];
+                if(trace != NULL)
+                    trace->coefs[terms[i]] += (color == WHITE) ? 1 : -1;
+            }
+        }
+
+        if(color == WHITE)
+            entry.score += score;
+        else
+            entry.score -= score;
+    }
+}
+
+PawnTable::PawnTable() : entries_(NUM_ENTRIES)
+{
+    // A key of 0 would match a board without pawns, so make sure no entry
+    // starts out matching anything
+    for(size_t i = 0; i < entries_.size(); i++)
+        entries_[i].key = 1;
+}
+
+const PawnEntry& PawnTable::probe(const Board& board)
+{
+    uint64_t key = board.pawnHash();
+    PawnEntry& entry = entries_[key & (NUM_ENTRIES - 1)];
+    if(entry.key != key)
+        evaluatePawns(board, entry);
+
+    return entry;
+}
@@ -0,0 +1,67 @@
+#ifndef CHESS_PAWNTABLE_H
+#define CHESS_PAWNTABLE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "bitboard.h"
+#include "board.h"
+#include "eval-params.h"
+#include "piece-square.h"
+
+/** What the evaluation knows about a pawn structure. */
+struct PawnEntry
+{
+    /** The pawn hash of the structure (see Board::pawnHash). */
+    uint64_t key;
+
+    /** The score of the structure, from White's point of view. */
+    Score score;
+
+    /** Each color's passed pawns, indexed by color. */
+    Bitboard passed [2];
+};
+
+/**
+ * Scores the pawn structure on the board from scratch, and fills in the
+ * entry. A pawn's file is its column along z, and it has up to eight
+ * neighbouring files, the ones it can capture onto. A pawn is:
+ *
+ * - passed if no enemy pawn is ahead of it on its own file or a neighbouring
+ *   one, and it earns more the further it has gone;
+ * - isolated if no pawn of its own is on a neighbouring file;
+ * - doubled if a pawn of its own is ahead of it on its file;
+ * - backward if none of its own pawns on the neighbouring files is level
+ *   with it or behind it, so none can come to defend it, and an enemy pawn
+ *   attacks the square in front of it.
+ *
+ * The scores of each are EvalParams. If there's a trace, the terms are
+ * counted in it as well.
+ */
+void evaluatePawns(const Board& board, PawnEntry& entry,
+        EvalTrace* trace = NULL);
+
+/**
+ * Remembers the scores of pawn structures, keyed by the pawn hash. The pawns
+ * change in few of the moves searched, so almost every lookup is a hit.
+ * Unlike the TranspositionTable, this isn't meant to be shared between
+ * threads: each search has its own.
+ */
+class PawnTable
+{
+  public:
+    /** Constructs an empty table. */
+    PawnTable();
+
+    /**
+     * Returns the entry for the board's pawn structure, evaluating it if it
+     * isn't in the table. The entry is only good until the next probe.
+     */
+    const PawnEntry& probe(const Board& board);
+
+  private:
+    /** The entries, indexed by the low bits of the key. */
+    std::vector<PawnEntry> entries_;
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include "piece-square.h"
+
+#include "eval-params.h"
+
+PieceSquare::Tables::Tables()
+{
+    fill(EvalParams());
+
+    // Leapers count for 1, sliders along one family of lines for 2, along
+    // two families (and the unicorn) for 3, and the queen for 4
+    const int PHASES [16] = {
+        0, 0, 0, 0,
+        1, 1, 1, 3,
+        2, 2, 2,
+        3, 3, 3,
+        4, 0
+    };
+    for(int pt = 0; pt < 16; pt++)
+        phases[pt] = PHASES[pt];
+}
+
+void PieceSquare::Tables::fill(const EvalParams& params)
+{
+    for(int pt = 0; pt < 16; pt++)
+    {
+        // Black pawns use the white pawns' table, flipped like everything else
+        int table = (pt == B_PAWN) ? W_PAWN : pt;
+        bool real = (pt != NIL && pt != BORDER);
+
+        const Score& material = params.scores[MATERIAL + table];
+        const Score& center = params.scores[CENTER + table];
+        const Score& advance = params.scores[ADVANCE + table];
+        const Score& files = params.scores[FILES + table];
+
+        for(int sq = 0; sq < NUM_SQUARES; sq++)
+        {
+            Score s;
+            if(real)
+            {
+                int c = centerTerm(sq), a = advanceTerm(sq), f = filesTerm(sq);
+                s.mg = material.mg + c * center.mg + a * advance.mg +
+                       f * files.mg;
+                s.eg = material.eg + c * center.eg + a * advance.eg +
+                       f * files.eg;
+            }
+
+            int flipped = squareAt(squareX(sq), squareY(sq), 7 - squareZ(sq));
+            scores[WHITE][pt][sq] = s;
+            scores[BLACK][pt][flipped] = Score(-s.mg, -s.eg);
+        }
+    }
+}
+
+void PieceSquare::setParams(const EvalParams& params)
+{
+    tables_.fill(params);
+}
+
+PieceSquare::Tables PieceSquare::tables_;
@@ -0,0 +1,109 @@
+#ifndef CHESS_PIECESQUARE_H
+#define CHESS_PIECESQUARE_H
+
+#include "common.h"
+#include "piece.h"
+
+/**
+ * A score with a middlegame and an endgame part, in hundredths of a pawn.
+ * The evaluation blends the two by how much material is left (the phase).
+ */
+struct Score
+{
+    /** Constructs a zero score. */
+    Score() : mg(0), eg(0)
+    {}
+
+    /** Constructs a score from its parts. */
+    Score(int mg, int eg) : mg(mg), eg(eg)
+    {}
+
+    Score& operator+=(const Score& o)
+    {
+        mg += o.mg;
+        eg += o.eg;
+        return *this;
+    }
+
+    Score& operator-=(const Score& o)
+    {
+        mg -= o.mg;
+        eg -= o.eg;
+        return *this;
+    }
+
+    bool operator==(const Score& o) const
+    {
+        return mg == o.mg && eg == o.eg;
+    }
+
+    int mg;
+    int eg;
+};
+
+/**
+ * The phase of the initial setup, and the most the phase is counted as. A
+ * position's phase is the sum of PieceSquare::phase over its pieces, so it
+ * falls from here towards 0 as pieces come off the board.
+ */
+const int MAX_PHASE = 238;
+
+struct EvalParams;
+
+/**
+ * The piece-square tables: what each piece is worth on each square, material
+ * included, from White's point of view. There are 13 tables, one for pawns
+ * (of both colors) and one for every other PieceType. Black's pieces use
+ * White's tables with the levels flipped (z becomes 7 - z, which is how the
+ * board is shown from Black's side) and the score negated, so the score of a
+ * whole position is just the sum over its pieces. Board keeps that sum up to
+ * date as pieces move.
+ *
+ * The tables are made from the evaluation's parameters (see EvalParams).
+ */
+class PieceSquare
+{
+  public:
+    /** Returns the score of the given piece standing on the given square. */
+    static const Score& piece(const Piece& p, int square)
+    {
+        return tables_.scores[p.color()][p.type()][square];
+    }
+
+    /** Returns how much a piece of the given type counts towards the phase. */
+    static int phase(PieceType pt)
+    {
+        return tables_.phases[pt];
+    }
+
+    /**
+     * Recomputes the tables from the given parameters. This is for
+     * setEvalParams, which says when it's safe to call.
+     */
+    static void setParams(const EvalParams& params);
+
+  private:
+    /** All the tables, computed once at startup. */
+    struct Tables
+    {
+        /** Fills in the tables, with the default parameters. */
+        Tables();
+
+        /** Fills in the scores from the given parameters. */
+        void fill(const EvalParams& params);
+
+        /** Indexed by color, PieceType and square. */
+        Score scores [2][16][NUM_SQUARES];
+
+        /** Indexed by PieceType. */
+        int phases [16];
+    };
+
+    /**
+     * The tables themselves. They're filled in during static initialization,
+     * so no Board should be set up from another static initializer.
+     */
+    static Tables tables_;
+};
+
+#endif
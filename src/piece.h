@@ -2,8 +2,9 @@
 #define CHESS_PIECE_H
 
 /**
- * A list of all piece types (and lack thereof). The value BORDER is special;
- * see the comments for "Board.pieces_" for more details. White and black pawns
+ * A list of all piece types (and lack thereof). The value BORDER is no longer
+ * put on the board; it only keeps the other values (and the tables indexed by
+ * them) where they've always been. White and black pawns
  * are different codes for two reasons. First, it means that (standard)
  * movements are entirely determined by PieceType. Second, it gives us an even
  * 16 types, which fit perfectly into a nibble.
@@ -34,6 +35,21 @@ const PieceType PROMOTION_PIECES [] = {
     QUEEN
 };
 
+/**
+ * A rough value for each PieceType, in hundredths of a pawn. There's no
+ * theory of 3D chess to take these from, so they follow mobility: the
+ * leapers reach 24 squares each, the bishop, moving along the diagonals of
+ * three planes, reaches more than the rook, and the compound pieces are worth
+ * a little more than their parts. The king can't be traded, so it's 0.
+ */
+const int PIECE_VALUES [16] = {
+    0, 0, 100, 100,
+    300, 325, 325, 900,
+    500, 600, 450,
+    1150, 1100, 1000,
+    1600, 0
+};
+
 /**
  * Represents a chess piece, including its color. Can also represent the lack
  * of a piece, with the values NIL and BORDER.
@@ -0,0 +1,588 @@
+#include "search.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <memory>
+#include <thread>
+
+#include "evaluate.h"
+
+typedef std::chrono::steady_clock Clock;
+
+// The static evaluation must never look like a mate
+static_assert(NNUE_MAX_SCORE < MATE_BOUND, "network scores look like mates");
+
+/** The first depth whose root window is narrowed around the last score. */
+static const int ASPIRATION_DEPTH = 4;
+
+/** How far either side of the last score the first window reaches. */
+static const int ASPIRATION_WINDOW = 50;
+
+/**
+ * How many nodes go by between looks at the clock and the node limit. A node
+ * takes around 10 microseconds at -O2, evaluation included, so this is a few
+ * milliseconds. The stop flag is only a relaxed load, and is checked at
+ * every node.
+ */
+static const uint64_t NODES_PER_CHECK = 256;
+
+/** How many of the quiet moves tried at a node can be penalised. */
+static const int MAX_QUIETS_TRIED = 64;
+
+SearchLimits::SearchLimits() : depth(MAX_PLY), nodes(0), milliseconds(0)
+{
+}
+
+SearchParams::SearchParams() :
+    null_min_depth(3), null_reduction(2), null_depth_divisor(4),
+    null_min_material(1000),
+    lmr_min_depth(3), lmr_min_moves(3), lmr_base(75), lmr_divisor(225),
+    delta_margin(200)
+{
+}
+
+/** The members of SearchParams, by name. */
+static const struct
+{
+    const char* name;
+    int SearchParams::* member;
+} PARAMS [] = {
+    { "null_min_depth", &SearchParams::null_min_depth },
+    { "null_reduction", &SearchParams::null_reduction },
+    { "null_depth_divisor", &SearchParams::null_depth_divisor },
+    { "null_min_material", &SearchParams::null_min_material },
+    { "lmr_min_depth", &SearchParams::lmr_min_depth },
+    { "lmr_min_moves", &SearchParams::lmr_min_moves },
+    { "lmr_base", &SearchParams::lmr_base },
+    { "lmr_divisor", &SearchParams::lmr_divisor },
+    { "delta_margin", &SearchParams::delta_margin }
+};
+
+bool SearchParams::set(const std::string& name, int value)
+{
+    for(size_t i = 0; i < sizeof(PARAMS) / sizeof(PARAMS[0]); i++)
+    {
+        if(name == PARAMS[i].name)
+        {
+            this->*PARAMS[i].member = value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+SearchResult::SearchResult() : score(0), depth(0), nodes(0), milliseconds(0),
+    cutoffs(0), first_move_cutoffs(0)
+{
+}
+
+/**
+ * Mate scores count plies from the root, but in the table, they count from
+ * the position stored, which might come up at another ply.
+ */
+static int scoreToTable(int score, int ply)
+{
+    if(score > MATE_BOUND)
+        return score + ply;
+    if(score < -MATE_BOUND)
+        return score - ply;
+    return score;
+}
+
+static int scoreFromTable(int score, int ply)
+{
+    if(score > MATE_BOUND)
+        return score - ply;
+    if(score < -MATE_BOUND)
+        return score + ply;
+    return score;
+}
+
+/** Returns true if the move is one of the given killers. */
+static bool isKiller(const Move& m, const Move* killers)
+{
+    for(int i = 0; i < NUM_KILLERS; i++)
+        if(m == killers[i])
+            return true;
+    return false;
+}
+
+/** Returns the value of the piece that a capture takes. */
+static int capturedValue(const Board& board, const Move& m)
+{
+    if(m.type() == EN_PASSANT)
+        return PIECE_VALUES[W_PAWN];
+    return PIECE_VALUES[board.getPiece(m.target()).type()];
+}
+
+Search::Search(const Board& board, TranspositionTable& table,
+        History& history) :
+    board_(board), table_(table), history_(history), stop_flag_(NULL),
+    helper_id_(0)
+{
+    setParams(SearchParams());
+}
+
+void Search::setStopFlag(const std::atomic<bool>* stop)
+{
+    stop_flag_ = stop;
+}
+
+void Search::setHelper(int id)
+{
+    helper_id_ = id;
+}
+
+void Search::setParams(const SearchParams& params)
+{
+    params_ = params;
+    params_.null_depth_divisor = std::max(params_.null_depth_divisor, 1);
+
+    // The reductions grow slowly with both the depth and the move number
+    double base = params_.lmr_base / 100.0;
+    double divisor = std::max(params_.lmr_divisor, 1) / 100.0;
+    for(int depth = 0; depth <= MAX_PLY; depth++)
+    {
+        for(int n = 0; n < MAX_REDUCED; n++)
+        {
+            double r = 0;
+            if(depth > 0 && n > 0)
+                r = base + std::log(depth) * std::log(n) / divisor;
+            reductions_[depth][n] = std::min(std::max((int) r, 0), 255);
+        }
+    }
+}
+
+SearchResult Search::run(const SearchLimits& limits, Listener listener)
+{
+    limits_ = limits;
+    start_ = Clock::now();
+    nodes_ = 0;
+    stopped_ = false;
+    last_pv_.clear();
+    table_stats_ = TableStats();
+    cutoffs_ = 0;
+    first_move_cutoffs_ = 0;
+
+    // Killers are only good for the position they were found in, but the
+    // history is still mostly right
+    for(int ply = 0; ply <= MAX_PLY; ply++)
+    {
+        for(int i = 0; i < NUM_KILLERS; i++)
+            killers_[ply][i] = Move();
+        null_move_[ply] = false;
+    }
+    history_.age();
+
+    // If the first iteration can't finish, any legal move is better than none
+    SearchResult result;
+    MoveList moves;
+    board_.generateLegalMoves(board_.whoseTurn(), moves);
+    if(moves.empty())
+        return result;
+    result.best_move = moves[0];
+
+    // Odd helpers stay a ply ahead of everyone else
+    int skip = helper_id_ % 2;
+
+    int max_depth = std::min(std::max(limits_.depth, 1), MAX_PLY);
+    for(int depth = 1 + skip; depth <= max_depth; depth++)
+    {
+        int delta = ASPIRATION_WINDOW;
+        int alpha = -INFINITE_SCORE;
+        int beta = INFINITE_SCORE;
+        if(depth >= ASPIRATION_DEPTH)
+        {
+            alpha = std::max(result.score - delta, -INFINITE_SCORE);
+            beta = std::min(result.score + delta, INFINITE_SCORE);
+        }
+
+        // Search, widening the window on whichever side the score fell out
+        int score;
+        root_found_ = false;
+        while(true)
+        {
+            following_pv_ = true;
+            score = search(alpha, beta, depth, 0);
+            if(stopped_)
+                break;
+
+            if(score <= alpha)
+                alpha = std::max(score - delta, -INFINITE_SCORE);
+            else if(score >= beta)
+                beta = std::min(score + delta, INFINITE_SCORE);
+            else
+                break;
+
+            delta *= 2;
+        }
+
+        // An unfinished iteration can't be trusted, unless it found a move at
+        // the root that is better than the last iteration's first choice (or
+        // than beta, which is as good). Moves aren't allowed to raise alpha
+        // before they've been searched completely, so that one was.
+        if(stopped_)
+        {
+            if(root_found_ && pv_[0][0] != result.best_move)
+            {
+                result.best_move = pv_[0][0];
+                result.score = root_score_;
+                result.pv.assign(pv_[0], pv_[0] + pv_length_[0]);
+            }
+            break;
+        }
+
+        result.best_move = pv_[0][0];
+        result.score = score;
+        result.depth = depth;
+        result.pv.assign(pv_[0], pv_[0] + pv_length_[0]);
+        result.nodes = nodes_;
+        result.milliseconds = elapsed();
+        result.table_stats = table_stats_;
+        result.cutoffs = cutoffs_;
+        result.first_move_cutoffs = first_move_cutoffs_;
+        last_pv_ = result.pv;
+
+        if(listener != NULL)
+            listener(result);
+
+        // There's no point looking past a forced mate. Otherwise the next
+        // iteration is started even if it can't finish, and the clock stops
+        // it: time that's left over isn't saved for later moves, and an
+        // unfinished iteration still counts if it has found a better move.
+        if(score > MATE_BOUND || score < -MATE_BOUND)
+            break;
+    }
+
+    result.nodes = nodes_;
+    result.milliseconds = elapsed();
+    result.table_stats = table_stats_;
+    result.cutoffs = cutoffs_;
+    result.first_move_cutoffs = first_move_cutoffs_;
+    return result;
+}
+
+int Search::search(int alpha, int beta, int depth, int ply)
+{
+    if(depth <= 0)
+        return quiesce(alpha, beta, ply);
+
+    pv_length_[ply] = 0;
+
+    if(shouldStop())
+        return 0;
+
+    nodes_++;
+
+    if(ply >= MAX_PLY)
+        return evaluate(board_, &pawns_);
+
+    bool color = board_.whoseTurn();
+    bool pv_node = (beta - alpha > 1);
+    bool in_check = board_.isInCheck(color);
+    int old_alpha = alpha;
+
+    // Outside the principal variation, a deep enough result from before is
+    // as good as searching again
+    TableEntry entry;
+    Move hash_move;
+    table_stats_.probes++;
+    if(table_.probe(board_.hash(), &entry))
+    {
+        table_stats_.hits++;
+        hash_move = entry.move;
+
+        int score = scoreFromTable(entry.score, ply);
+        if(!pv_node && entry.depth >= depth &&
+           (entry.bound == BOUND_EXACT ||
+            (entry.bound == BOUND_LOWER && score >= beta) ||
+            (entry.bound == BOUND_UPPER && score <= alpha)))
+            return score;
+    }
+
+    // If passing the turn doesn't stop us from beating beta, then surely
+    // some move won't either. That isn't so when every move makes things
+    // worse (zugzwang), which mostly happens when there's little besides
+    // pawns left, and we never pass twice in a row.
+    if(!pv_node && !in_check && !null_move_[ply] &&
+       depth >= params_.null_min_depth &&
+       nonPawnMaterial(board_, color) >= params_.null_min_material &&
+       evaluate(board_, &pawns_) >= beta)
+    {
+        int r = params_.null_reduction + depth / params_.null_depth_divisor;
+
+        board_.makeNullMove();
+        null_move_[ply + 1] = true;
+        int score = -search(-beta, -beta + 1, depth - 1 - r, ply + 1);
+        null_move_[ply + 1] = false;
+        board_.undoNullMove();
+
+        if(stopped_)
+            return 0;
+
+        // A mate found after passing may not be a real one
+        if(score >= beta)
+            return (score > MATE_BOUND) ? beta : score;
+    }
+
+    // Follow the last iteration's principal variation, as long as we're on it
+    if(following_pv_ && ply < (int) last_pv_.size())
+        hash_move = last_pv_[ply];
+
+    MovePicker picker (board_, hash_move, killers_[ply], &history_);
+    int best_score = -INFINITE_SCORE;
+    Move best_move;
+    int num_legal = 0;
+
+    // The quiet moves tried so far, which are penalised if another one
+    // turns out to cut off
+    Move quiets_tried [MAX_QUIETS_TRIED];
+    int num_quiets = 0;
+
+    for(Move m = picker.next(); m != Move(); m = picker.next())
+    {
+        if(!board_.isLegalMove(m))
+            continue;
+
+        board_.makeMove(m);
+        num_legal++;
+
+        int score;
+        if(num_legal == 1)
+            score = -search(-beta, -alpha, depth - 1, ply + 1);
+        else
+        {
+            // Late quiet moves are rarely any good, so they're searched
+            // shallower at first, unless they're killers or give check. The
+            // reduced search still goes at least a ply.
+            int r = 0;
+            if(depth >= params_.lmr_min_depth &&
+               num_legal > params_.lmr_min_moves && m.isQuiet() &&
+               !in_check && !isKiller(m, killers_[ply]) &&
+               !board_.isInCheck(!color))
+            {
+                r = reductions_[depth][std::min(num_legal, MAX_REDUCED - 1)];
+                r = std::max(std::min(r - pv_node, depth - 2), 0);
+            }
+
+            // Prove that this move is no better than the first, and only if
+            // that fails, find out how good it is
+            score = -search(-alpha - 1, -alpha, depth - 1 - r, ply + 1);
+            if(r > 0 && score > alpha)
+                score = -search(-alpha - 1, -alpha, depth - 1, ply + 1);
+            if(score > alpha && score < beta)
+                score = -search(-beta, -alpha, depth - 1, ply + 1);
+        }
+
+        board_.undoMove();
+
+        // Everything after the first move leaves the last principal variation
+        following_pv_ = false;
+
+        if(stopped_)
+            return 0;
+
+        if(score > best_score)
+            best_score = score;
+
+        if(score > alpha)
+        {
+            alpha = score;
+            best_move = m;
+
+            // This move starts the new principal variation
+            pv_[ply][0] = m;
+            for(int i = 0; i < pv_length_[ply + 1]; i++)
+                pv_[ply][i + 1] = pv_[ply + 1][i];
+            pv_length_[ply] = pv_length_[ply + 1] + 1;
+
+            if(ply == 0)
+            {
+                root_found_ = true;
+                root_score_ = score;
+            }
+
+            if(alpha >= beta)
+            {
+                cutoffs_++;
+                if(num_legal == 1)
+                    first_move_cutoffs_++;
+
+                if(m.isQuiet())
+                    updateOrdering(m, quiets_tried, num_quiets, depth, ply);
+                break;
+            }
+        }
+
+        if(m.isQuiet() && num_quiets < MAX_QUIETS_TRIED)
+            quiets_tried[num_quiets++] = m;
+    }
+
+    // No legal moves: checkmate or stalemate
+    if(num_legal == 0)
+        best_score = in_check ? -MATE_SCORE + ply : 0;
+
+    Bound bound = BOUND_EXACT;
+    if(best_score >= beta)
+        bound = BOUND_LOWER;
+    else if(best_score <= old_alpha)
+        bound = BOUND_UPPER;
+
+    table_stats_.stores++;
+    if(table_.store(board_.hash(), best_move, scoreToTable(best_score, ply),
+            depth, bound))
+        table_stats_.collisions++;
+
+    return best_score;
+}
+
+int Search::quiesce(int alpha, int beta, int ply)
+{
+    pv_length_[ply] = 0;
+
+    if(shouldStop())
+        return 0;
+
+    nodes_++;
+
+    // Standing pat: not capturing is always an option
+    int best_score = evaluate(board_, &pawns_);
+    if(ply >= MAX_PLY || best_score >= beta)
+        return best_score;
+    if(best_score > alpha)
+        alpha = best_score;
+
+    // The picker leaves out the captures that lose material
+    MovePicker picker (board_, Move());
+    for(Move m = picker.next(); m != Move(); m = picker.next())
+    {
+        // If even taking the piece for nothing can't raise alpha, don't
+        // bother. Promotions are worth more than what they take, though.
+        if(m.type() != PROMO_CAPTURE &&
+           best_score + capturedValue(board_, m) + params_.delta_margin <=
+           alpha)
+            continue;
+
+        if(!board_.isLegalMove(m))
+            continue;
+
+        board_.makeMove(m);
+        int score = -quiesce(-beta, -alpha, ply + 1);
+        board_.undoMove();
+
+        if(stopped_)
+            return 0;
+
+        if(score > best_score)
+        {
+            best_score = score;
+            if(score > alpha)
+            {
+                alpha = score;
+                if(alpha >= beta)
+                    break;
+            }
+        }
+    }
+
+    return best_score;
+}
+
+void Search::updateOrdering(const Move& m, const Move* quiets_tried,
+        int num_quiets, int depth, int ply)
+{
+    Move* killers = killers_[ply];
+    if(killers[0] != m)
+    {
+        for(int i = NUM_KILLERS - 1; i > 0; i--)
+            killers[i] = killers[i - 1];
+        killers[0] = m;
+    }
+
+    int bonus = depth * depth;
+    history_.update(m, bonus);
+    for(int i = 0; i < num_quiets; i++)
+        history_.update(quiets_tried[i], -bonus);
+}
+
+bool Search::shouldStop()
+{
+    if(stopped_)
+        return true;
+
+    if(stop_flag_ != NULL && stop_flag_->load(std::memory_order_relaxed))
+    {
+        stopped_ = true;
+        return true;
+    }
+
+    if(nodes_ % NODES_PER_CHECK != 0)
+        return false;
+
+    if(limits_.nodes > 0 && nodes_ >= limits_.nodes)
+        stopped_ = true;
+    if(helper_id_ == 0 && limits_.milliseconds > 0 &&
+       elapsed() >= limits_.milliseconds)
+        stopped_ = true;
+
+    return stopped_;
+}
+
+int Search::elapsed() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+            Clock::now() - start_).count();
+}
+
+SearchResult parallelSearch(const Board& board, TranspositionTable& table,
+        std::vector<History>& histories, const SearchLimits& limits,
+        const SearchParams& params, std::atomic<bool>& stop,
+        Search::Listener listener)
+{
+    assert(!histories.empty());
+    int num_threads = histories.size();
+
+    // The helpers only stop when told to, so they get no time or node limit
+    SearchLimits helper_limits;
+    helper_limits.depth = limits.depth;
+
+    std::vector<std::unique_ptr<Search> > helpers;
+    std::vector<SearchResult> helped (num_threads);
+    std::vector<std::thread> threads;
+    for(int id = 1; id < num_threads; id++)
+    {
+        Search* helper = new Search(board, table, histories[id]);
+        helper->setStopFlag(&stop);
+        helper->setHelper(id);
+        helper->setParams(params);
+        helpers.push_back(std::unique_ptr<Search>(helper));
+
+        SearchResult* out = &helped[id];
+        threads.push_back(std::thread([helper, helper_limits, out]()
+        {
+            *out = helper->run(helper_limits);
+        }));
+    }
+
+    Search main_search (board, table, histories[0]);
+    main_search.setStopFlag(&stop);
+    main_search.setParams(params);
+    SearchResult result = main_search.run(limits, listener);
+
+    stop = true;
+    for(size_t n = 0; n < threads.size(); n++)
+        threads[n].join();
+
+    // The helpers' work counts too
+    for(int id = 1; id < num_threads; id++)
+    {
+        result.nodes += helped[id].nodes;
+        result.table_stats += helped[id].table_stats;
+        result.cutoffs += helped[id].cutoffs;
+        result.first_move_cutoffs += helped[id].first_move_cutoffs;
+    }
+
+    return result;
+}
@@ -0,0 +1,318 @@
+#ifndef CHESS_SEARCH_H
+#define CHESS_SEARCH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "board.h"
+#include "history.h"
+#include "move.h"
+#include "move-picker.h"
+#include "pawn-table.h"
+#include "transposition-table.h"
+
+/** The most plies the search will look ahead of the root. */
+const int MAX_PLY = 64;
+
+/**
+ * The score of being checkmated right now. Being mated n plies from the root
+ * scores -(MATE_SCORE - n), so that quicker mates score further from 0.
+ */
+const int MATE_SCORE = 32000;
+
+/** Scores further from 0 than this are mates. */
+const int MATE_BOUND = MATE_SCORE - MAX_PLY;
+
+/** Bounds every score the search can return. */
+const int INFINITE_SCORE = MATE_SCORE + 1;
+
+/**
+ * How long a search may go on. It stops at whichever limit comes first; a
+ * limit of 0 means there isn't one (except for depth, which is capped at
+ * MAX_PLY).
+ */
+struct SearchLimits
+{
+    /** Constructs limits that let the search go on until MAX_PLY. */
+    SearchLimits();
+
+    /** The deepest iteration to search, in plies. */
+    int depth;
+
+    /** How many nodes to search. */
+    uint64_t nodes;
+
+    /** How long to search, in milliseconds. */
+    int milliseconds;
+};
+
+/**
+ * The knobs of the search's pruning, which can be tuned without rebuilding.
+ * Depths are in plies.
+ */
+struct SearchParams
+{
+    /** Constructs the default parameters. */
+    SearchParams();
+
+    /**
+     * Sets the parameter with the given name (as in the members below) to the
+     * given value. Returns false if there is no such parameter.
+     */
+    bool set(const std::string& name, int value);
+
+    /**
+     * Null-move pruning: a null move is tried from null_min_depth on, and
+     * searched to depth - 1 - (null_reduction + depth / null_depth_divisor).
+     * A side whose pieces (not counting pawns) are worth less than
+     * null_min_material might be in zugzwang, so it doesn't get one.
+     */
+    int null_min_depth;
+    int null_reduction;
+    int null_depth_divisor;
+    int null_min_material;
+
+    /**
+     * Late move reductions: from lmr_min_depth on, quiet moves after the
+     * first lmr_min_moves are searched lmr_base / 100 + ln(depth) *
+     * ln(move number) / (lmr_divisor / 100) plies shallower, and searched
+     * again at full depth if they beat alpha anyway.
+     */
+    int lmr_min_depth;
+    int lmr_min_moves;
+    int lmr_base;
+    int lmr_divisor;
+
+    /**
+     * Delta pruning: a capture in the quiescence search is skipped when
+     * taking the piece, and this much besides, still wouldn't raise alpha.
+     */
+    int delta_margin;
+};
+
+/**
+ * What a search found, as of its last completed iteration, or later if an
+ * unfinished iteration has already found something better.
+ */
+struct SearchResult
+{
+    /** Constructs an empty result, with a nil best move. */
+    SearchResult();
+
+    /** The move to play, or nil if there are no legal moves. */
+    Move best_move;
+
+    /** The score of the best move, from the side to move's point of view. */
+    int score;
+
+    /** The depth that the result comes from. */
+    int depth;
+
+    /** How many nodes have been searched in all. */
+    uint64_t nodes;
+
+    /** How long the search has taken, in milliseconds. */
+    int milliseconds;
+
+    /** The moves both sides are expected to play, starting with best_move. */
+    std::vector<Move> pv;
+
+    /** What happened to the search's probes and stores in the table. */
+    TableStats table_stats;
+
+    /**
+     * How many nodes were cut off, and at how many of those it was the first
+     * move that did it, which measures how good the move ordering is.
+     */
+    uint64_t cutoffs;
+    uint64_t first_move_cutoffs;
+};
+
+/**
+ * A negamax alpha-beta search over a copy of a board. Each call to run does
+ * an iterative deepening search, one ply deeper each iteration, so that
+ * there's always a best move to play when a limit runs out. The earlier
+ * iterations also pay for themselves, since they give the next one its
+ * principal variation to search first.
+ *
+ * Within an iteration, the first move at each node is searched with the full
+ * window, and the others with a null window around alpha, only to be
+ * searched again if they turn out better (principal variation search). From
+ * ASPIRATION_DEPTH on, the root window is narrowed around the last score,
+ * and widened when the score falls outside it.
+ *
+ * Not every move is searched to the full depth. Outside the principal
+ * variation, if passing the turn (a null move) and searching shallower still
+ * beats beta, the node is cut off at once; and quiet moves late in the order
+ * are searched shallower, unless they turn out to beat alpha. At the leaves,
+ * a quiescence search plays out the captures that don't lose material, so
+ * that the static evaluation is only ever used in quiet positions. See
+ * SearchParams.
+ *
+ * Every node's result goes into a transposition table, which may be shared
+ * with other searches. Its best move is searched first when the position
+ * comes up again, and its score is used outright where it's good enough
+ * (though never in the principal variation, which would cut it short).
+ *
+ * The other moves are ordered by a MovePicker. Quiet moves that cause a
+ * cutoff become the killer moves of their ply, to be tried early in the
+ * sibling nodes, and earn a bonus in the History, which orders the rest.
+ *
+ * Several searches can run at once on the same table (Lazy SMP): each fills
+ * in positions that the others then find there. Helpers are given an id, and
+ * the odd ones search a ply deeper at each iteration, so that the threads
+ * don't all search the same tree in step. See parallelSearch.
+ */
+class Search
+{
+  public:
+    /** Called with the result of each iteration, as it completes. */
+    typedef void (*Listener)(const SearchResult& result);
+
+    /**
+     * Constructs a search from the position on the given board, which keeps
+     * its results in the given table. Whoever owns the table should call its
+     * newSearch before each run. The history is the search's own, and is
+     * aged at the start of each run.
+     */
+    Search(const Board& board, TranspositionTable& table, History& history);
+
+    /**
+     * Makes the search also stop once the given flag is set, which is checked
+     * as often as the other limits.
+     */
+    void setStopFlag(const std::atomic<bool>* stop);
+
+    /**
+     * Makes this a helper search with the given id (from 1 up), whose results
+     * only matter for what it puts in the table. A helper ignores the time
+     * limit, so something else has to stop it.
+     */
+    void setHelper(int id);
+
+    /** Sets the parameters of the pruning. */
+    void setParams(const SearchParams& params);
+
+    /**
+     * Searches until a limit is reached, and returns the best move found. If
+     * the last iteration didn't finish, but got far enough to find a new best
+     * move at the root, that's the one returned. If there is a listener, it's
+     * told about each completed iteration.
+     */
+    SearchResult run(const SearchLimits& limits, Listener listener = NULL);
+
+  private:
+    /**
+     * Searches the position to the given depth, and returns its score for the
+     * side to move, which is exact only if it's between alpha and beta.
+     */
+    int search(int alpha, int beta, int depth, int ply);
+
+    /**
+     * Searches just the captures, until the position is quiet, and returns
+     * its score as search does. The side to move can always choose not to
+     * capture, so the static evaluation is a lower bound.
+     */
+    int quiesce(int alpha, int beta, int ply);
+
+    /**
+     * Checks the stop flag, and every so often the time and node limits, and
+     * returns true if the search should stop.
+     */
+    bool shouldStop();
+
+    /**
+     * Makes the quiet move that just caused a cutoff a killer at this ply,
+     * and rewards it in the history, while penalising the quiet moves that
+     * were tried before it and didn't.
+     */
+    void updateOrdering(const Move& m, const Move* quiets_tried,
+            int num_quiets, int depth, int ply);
+
+    /** Returns how long the search has been running, in milliseconds. */
+    int elapsed() const;
+
+    /** The board being searched. Every move made is undone again. */
+    Board board_;
+
+    /** Where results are kept, and what has happened to it this run. */
+    TranspositionTable& table_;
+    TableStats table_stats_;
+
+    /** The pawn structures this search has evaluated. */
+    PawnTable pawns_;
+
+    /** How well this search has been ordering its moves. */
+    History& history_;
+    Move killers_ [MAX_PLY + 1][NUM_KILLERS];
+    uint64_t cutoffs_;
+    uint64_t first_move_cutoffs_;
+
+    /**
+     * The parameters, and the late move reductions they give, indexed by
+     * depth and by how many moves have been tried (capped at MAX_REDUCED).
+     */
+    SearchParams params_;
+    static const int MAX_REDUCED = 256;
+    unsigned char reductions_ [MAX_PLY + 1][MAX_REDUCED];
+
+    /** Whether the move into each ply was a null move. */
+    bool null_move_ [MAX_PLY + 1];
+
+    /** The limits of the current run. */
+    SearchLimits limits_;
+
+    /** When the current run started. */
+    std::chrono::steady_clock::time_point start_;
+
+    /** How many nodes the current run has searched. */
+    uint64_t nodes_;
+
+    /** Set once a limit has been reached, to unwind the search. */
+    bool stopped_;
+
+    /** A flag that stops the search when set, or NULL. */
+    const std::atomic<bool>* stop_flag_;
+
+    /** 0 for the main search, and the helper's id for a helper. */
+    int helper_id_;
+
+    /**
+     * The principal variation of each ply, found during the current iteration:
+     * pv_[ply] holds pv_length_[ply] moves, starting with the move from ply.
+     */
+    Move pv_ [MAX_PLY + 1][MAX_PLY + 1];
+    int pv_length_ [MAX_PLY + 1];
+
+    /**
+     * Whether the current iteration has found a best move at the root, and
+     * what it scored. If the iteration is stopped, this can still be used.
+     */
+    bool root_found_;
+    int root_score_;
+
+    /**
+     * The principal variation of the last iteration. While the search is
+     * still following it, its moves are tried first.
+     */
+    std::vector<Move> last_pv_;
+    bool following_pv_;
+};
+
+/**
+ * Searches on one thread for each of the given histories (there must be at
+ * least one), all sharing the table. The calling thread runs the main search,
+ * with the first history, which decides the result (and is the one the
+ * listener hears about), and the others run helpers. Once the main search
+ * stops, so do the helpers, and the nodes they searched are added to the
+ * result. Setting the stop flag stops them all.
+ */
+SearchResult parallelSearch(const Board& board, TranspositionTable& table,
+        std::vector<History>& histories, const SearchLimits& limits,
+        const SearchParams& params, std::atomic<bool>& stop,
+        Search::Listener listener = NULL);
+
+#endif
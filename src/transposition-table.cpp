@@ -0,0 +1,233 @@
+#include "transposition-table.h"
+
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <sys/mman.h>
+
+/** The size of a huge page, which large tables are aligned to. */
+static const size_t HUGE_PAGE_SIZE = 2 << 20;
+
+/** How many buckets occupancy looks at. */
+static const size_t OCCUPANCY_SAMPLE = 1000;
+
+/**
+ * How many plies of depth an entry is worth less for each search it's out of
+ * date, when choosing one to replace.
+ */
+static const int AGE_PENALTY = 8;
+
+/** Packs the parts of an entry into its data word. */
+static uint64_t pack(const Move& move, int score, int depth, Bound bound,
+        int age)
+{
+    return (uint64_t) move.bits() |
+           ((uint64_t) (uint16_t) score << 32) |
+           ((uint64_t) (depth & 0xFF) << 48) |
+           ((uint64_t) bound << 56) |
+           ((uint64_t) age << 58);
+}
+
+static Move packedMove(uint64_t data)
+{
+    return Move::fromBits((unsigned int) data);
+}
+
+static int packedScore(uint64_t data)
+{
+    return (int16_t) (data >> 32);
+}
+
+static int packedDepth(uint64_t data)
+{
+    return (data >> 48) & 0xFF;
+}
+
+static Bound packedBound(uint64_t data)
+{
+    return static_cast<Bound>((data >> 56) & 0x3);
+}
+
+static int packedAge(uint64_t data)
+{
+    return data >> 58;
+}
+
+/**
+ * Allocates memory for the table, aligned to a cache line, or to a huge page
+ * if it's that big. Returns NULL on failure.
+ */
+static void* allocate(size_t bytes)
+{
+    size_t alignment = (bytes >= HUGE_PAGE_SIZE) ? HUGE_PAGE_SIZE : 64;
+
+    void* memory;
+    if(posix_memalign(&memory, alignment, bytes) != 0)
+        return NULL;
+
+#ifdef MADV_HUGEPAGE
+    // Only a hint; without huge pages, the table just uses normal ones
+    if(alignment == HUGE_PAGE_SIZE)
+        madvise(memory, bytes, MADV_HUGEPAGE);
+#endif
+
+    return memory;
+}
+
+TableStats::TableStats() : probes(0), hits(0), stores(0), collisions(0)
+{
+}
+
+TableStats& TableStats::operator+=(const TableStats& s)
+{
+    probes += s.probes;
+    hits += s.hits;
+    stores += s.stores;
+    collisions += s.collisions;
+    return *this;
+}
+
+TranspositionTable::TranspositionTable(size_t megabytes) :
+    buckets_(NULL), num_buckets_(0), age_(0)
+{
+    resize(megabytes);
+}
+
+TranspositionTable::~TranspositionTable()
+{
+    free(buckets_);
+}
+
+void TranspositionTable::resize(size_t megabytes)
+{
+    size_t num_buckets = 1;
+    while(num_buckets * 2 * sizeof(Bucket) <= megabytes << 20)
+        num_buckets *= 2;
+
+    void* memory = allocate(num_buckets * sizeof(Bucket));
+    if(memory == NULL)
+        throw std::bad_alloc();
+
+    free(buckets_);
+    buckets_ = static_cast<Bucket*>(memory);
+    num_buckets_ = num_buckets;
+    clear();
+}
+
+void TranspositionTable::clear()
+{
+    // All zeroes is an empty entry, since a stored one always has a bound
+    memset(static_cast<void*>(buckets_), 0, num_buckets_ * sizeof(Bucket));
+    age_ = 0;
+}
+
+void TranspositionTable::newSearch()
+{
+    age_ = (age_ + 1) & 0x3F;
+}
+
+bool TranspositionTable::probe(uint64_t hash, TableEntry* entry) const
+{
+    Bucket& bucket = bucketFor(hash);
+    for(int i = 0; i < BUCKET_SIZE; i++)
+    {
+        const Entry& e = bucket.entries[i];
+        uint64_t data = e.data.load(std::memory_order_relaxed);
+        uint64_t check = e.check.load(std::memory_order_relaxed);
+
+        if(data == 0 || (check ^ data) != hash)
+            continue;
+
+        entry->move = packedMove(data);
+        entry->score = packedScore(data);
+        entry->depth = packedDepth(data);
+        entry->bound = packedBound(data);
+        return true;
+    }
+
+    return false;
+}
+
+bool TranspositionTable::store(uint64_t hash, const Move& move, int score,
+        int depth, Bound bound)
+{
+    Bucket& bucket = bucketFor(hash);
+
+    // Use the position's own entry if it has one, and otherwise push out the
+    // least valuable one
+    Entry* replaced = NULL;
+    uint64_t replaced_data = 0;
+    bool same = false;
+    int worst = INT_MAX;
+
+    for(int i = 0; i < BUCKET_SIZE; i++)
+    {
+        Entry& e = bucket.entries[i];
+        uint64_t data = e.data.load(std::memory_order_relaxed);
+        uint64_t check = e.check.load(std::memory_order_relaxed);
+
+        if(data != 0 && (check ^ data) == hash)
+        {
+            replaced = &e;
+            replaced_data = data;
+            same = true;
+            break;
+        }
+
+        int value = INT_MIN;
+        if(data != 0)
+        {
+            int age = (age_ - packedAge(data)) & 0x3F;
+            value = packedDepth(data) - AGE_PENALTY * age;
+        }
+
+        if(value < worst)
+        {
+            replaced = &e;
+            replaced_data = data;
+            worst = value;
+        }
+    }
+
+    Move kept = move;
+    if(same && move == Move())
+        kept = packedMove(replaced_data);
+
+    uint64_t data = pack(kept, score, depth, bound, age_);
+    replaced->data.store(data, std::memory_order_relaxed);
+    replaced->check.store(hash ^ data, std::memory_order_relaxed);
+
+    return !same && replaced_data != 0 && packedAge(replaced_data) == age_;
+}
+
+size_t TranspositionTable::size() const
+{
+    return num_buckets_ * sizeof(Bucket);
+}
+
+double TranspositionTable::occupancy() const
+{
+    size_t sample = (num_buckets_ < OCCUPANCY_SAMPLE) ? num_buckets_ :
+            OCCUPANCY_SAMPLE;
+
+    size_t used = 0;
+    for(size_t n = 0; n < sample; n++)
+    {
+        for(int i = 0; i < BUCKET_SIZE; i++)
+        {
+            uint64_t data =
+                    buckets_[n].entries[i].data.load(std::memory_order_relaxed);
+            if(data != 0 && packedAge(data) == age_)
+                used++;
+        }
+    }
+
+    return (double) used / (sample * BUCKET_SIZE);
+}
+
+TranspositionTable::Bucket& TranspositionTable::bucketFor(uint64_t hash) const
+{
+    return buckets_[hash & (num_buckets_ - 1)];
+}
@@ -0,0 +1,145 @@
+#ifndef CHESS_TRANSPOSITIONTABLE_H
+#define CHESS_TRANSPOSITIONTABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "move.h"
+
+/**
+ * What a stored score says about the true score: that it's exact, or only a
+ * lower bound (the search failed high) or an upper bound (it failed low).
+ */
+enum Bound {
+    BOUND_NONE, BOUND_UPPER, BOUND_LOWER, BOUND_EXACT
+};
+
+/** What the table remembers about a position. */
+struct TableEntry
+{
+    /** The best move found, or nil if none was. */
+    Move move;
+
+    /** The score, from the side to move's point of view. */
+    int score;
+
+    /** The depth the score was searched to. */
+    int depth;
+
+    /** Which kind of bound the score is. */
+    Bound bound;
+};
+
+/** Counts of what happened to a table's probes and stores. */
+struct TableStats
+{
+    /** Constructs all-zero counts. */
+    TableStats();
+
+    /** Adds another set of counts to these. */
+    TableStats& operator+=(const TableStats& s);
+
+    /** How many positions were looked up, and how many were found. */
+    uint64_t probes;
+    uint64_t hits;
+
+    /**
+     * How many positions were stored, and how many of those pushed out a
+     * different position stored during the same search.
+     */
+    uint64_t stores;
+    uint64_t collisions;
+};
+
+/**
+ * Remembers the results of searching positions, keyed by their Zobrist hash,
+ * so that transpositions (and the next iteration) don't have to search them
+ * again. It's meant to be shared between threads.
+ *
+ * The table is an array of buckets, each the size of a cache line, so a probe
+ * touches just one line. Each bucket holds a few entries, and a new position
+ * replaces the least useful one: from an older search, or searched the least
+ * deeply. No locks are used. Each entry is two words, the data and the hash
+ * XORed with the data, and a probe only believes an entry if the two agree.
+ * An entry torn by two threads writing at once won't, so it's just a miss.
+ */
+class TranspositionTable
+{
+  public:
+    /** Constructs a table of about the given size, in megabytes. */
+    explicit TranspositionTable(size_t megabytes);
+
+    /** Frees the table. */
+    ~TranspositionTable();
+
+    /**
+     * Reallocates the table to about the given size, in megabytes (but at
+     * least one bucket), and clears it. Where the system supports it, large
+     * tables are put in huge pages, to save on TLB misses.
+     */
+    void resize(size_t megabytes);
+
+    /** Forgets every position. No search may be using the table. */
+    void clear();
+
+    /**
+     * Starts a new search, whose entries are worth more than the old ones.
+     * Call this before starting the search's threads.
+     */
+    void newSearch();
+
+
+    /** Looks up a position. Returns true, and fills in entry, if found. */
+    bool probe(uint64_t hash, TableEntry* entry) const;
+
+    /**
+     * Stores the result of searching a position. If the position is already
+     * stored, a nil move keeps the move that was there. Returns true if this
+     * pushed out a different position from the same search.
+     */
+    bool store(uint64_t hash, const Move& move, int score, int depth,
+            Bound bound);
+
+
+    /** Returns the size of the table, in bytes. */
+    size_t size() const;
+
+    /**
+     * Returns the fraction of entries used by the current search, estimated
+     * from the first thousand buckets.
+     */
+    double occupancy() const;
+
+  private:
+    /** The entries in a bucket, which fill a 64-byte cache line. */
+    static const int BUCKET_SIZE = 4;
+
+    /**
+     * One entry. data packs the move (bits 0-31), the score (32-47), the
+     * depth (48-55), the bound (56-57) and the search's age (58-63). check
+     * is the hash XORed with data.
+     */
+    struct Entry
+    {
+        std::atomic<uint64_t> check;
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(64) Bucket
+    {
+        Entry entries [BUCKET_SIZE];
+    };
+
+    /** Returns the bucket that the given hash belongs in. */
+    Bucket& bucketFor(uint64_t hash) const;
+
+    /** The buckets, and how many there are (a power of two). */
+    Bucket* buckets_;
+    size_t num_buckets_;
+
+    /** The current search's age, which wraps around after 64 searches. */
+    uint8_t age_;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#include "zobrist.h"
+
+/**
+ * A small, fast pseudo-random generator (splitmix64). It only has to be
+ * well-distributed; it doesn't have to be unpredictable.
+ */
+static uint64_t nextRandom(uint64_t& state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+Zobrist::Keys::Keys()
+{
+    uint64_t state = 0x3D0C4E55;
+
+    for(int color = 0; color < 2; color++)
+        for(int pt = 0; pt < 16; pt++)
+            for(int sq = 0; sq < 512; sq++)
+                pieces[color][pt][sq] = nextRandom(state);
+
+    for(int i = 0; i < 12; i++)
+        castling[i] = nextRandom(state);
+
+    for(int sq = 0; sq < 512; sq++)
+        en_passant[sq] = nextRandom(state);
+
+    side = nextRandom(state);
+}
+
+uint64_t Zobrist::castling(int rights)
+{
+    uint64_t key = 0;
+    for(int i = 0; i < 12; i++)
+        if(rights & (1 << i))
+            key ^= keys_.castling[i];
+    return key;
+}
+
+const Zobrist::Keys Zobrist::keys_;
@@ -0,0 +1,70 @@
+#ifndef CHESS_ZOBRIST_H
+#define CHESS_ZOBRIST_H
+
+#include <cstdint>
+
+#include "piece.h"
+
+/**
+ * The random keys that make up a Zobrist hash. A position's hash is the XOR
+ * of the keys for each piece on each square, each castling right held, the
+ * en passant square (if any), and the side to move. Since XOR is its own
+ * inverse, making or undoing a move only has to XOR in the keys that changed.
+ *
+ * Squares here are numbered 0 to 511, with x varying first, then y, then z.
+ */
+class Zobrist
+{
+  public:
+    /** Returns the key for the given piece standing on the given square. */
+    static uint64_t piece(const Piece& p, int square)
+    {
+        return keys_.pieces[p.color()][p.type()][square];
+    }
+
+    /** Returns the XOR of the keys for each castling right that is set. */
+    static uint64_t castling(int rights);
+
+    /** Returns the key for an en passant square. */
+    static uint64_t enPassant(int square)
+    {
+        return keys_.en_passant[square];
+    }
+
+    /** Returns the key that is toggled every time a move is made. */
+    static uint64_t side()
+    {
+        return keys_.side;
+    }
+
+  private:
+    /**
+     * All the keys, generated from a fixed seed, so that hashes are the same
+     * from run to run.
+     */
+    struct Keys
+    {
+        /** Fills in the keys. */
+        Keys();
+
+        /** Indexed by color, PieceType, and square. */
+        uint64_t pieces [2][16][512];
+
+        /** One key per castling right, in the order of the rights bits. */
+        uint64_t castling [12];
+
+        /** Indexed by square. */
+        uint64_t en_passant [512];
+
+        /** Toggled on each move. */
+        uint64_t side;
+    };
+
+    /**
+     * The keys themselves. They're filled in during static initialization,
+     * so no Board should be set up from another static initializer.
+     */
+    static const Keys keys_;
+};
+
+#endif
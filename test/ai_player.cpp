@@ -0,0 +1,78 @@
+#include "../src/ai-player.h"
+#include "../src/board.h"
+#include "../src/opening-book.h"
+
+#include "unit_test.h"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+TEST(AiPlayer, Interrupt)
+{
+    Board b;
+    b.setup();
+
+    // With no limits, only an interrupt will stop it
+    AiPlayer ai;
+    ai.setLimits(SearchLimits());
+    ai.setThreads(2);
+
+    Move m;
+    std::thread thinker ([&]()
+    {
+        m = ai.requestMove(WHITE, b);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    ai.interrupt();
+    thinker.join();
+    std::chrono::duration<double, std::milli> waited = Clock::now() - start;
+
+    // Every node checks the flag, so this is well under a millisecond, and
+    // the rest of the bound is for the threads to be scheduled
+    EXPECT_LT(waited.count(), 20);
+
+    MoveList moves;
+    b.generateLegalMoves(WHITE, moves);
+    EXPECT_TRUE(moves.contains(m));
+
+    // An interrupt that comes before the search starts isn't lost
+    ai.interrupt();
+    start = Clock::now();
+    m = ai.requestMove(WHITE, b);
+    waited = Clock::now() - start;
+
+    // This is mostly setting up the search, which takes tens of milliseconds
+    // unoptimised
+    EXPECT_LT(waited.count(), 100);
+    EXPECT_TRUE(moves.contains(m));
+}
+
+TEST(AiPlayer, Book)
+{
+    Board b;
+    b.setup();
+
+    MoveList moves;
+    b.generateLegalMoves(WHITE, moves);
+    Move m = moves[moves.size() / 2];
+
+    const char* path = "log/ai_book_test.bin";
+    BookBuilder builder;
+    builder.add(b.hash(), m, 0.5);
+    ASSERT_TRUE(builder.write(path, 1));
+
+    // In the book, the player doesn't think at all
+    AiPlayer ai;
+    ai.setLimits(SearchLimits());
+    ASSERT_TRUE(ai.setBook(path));
+    EXPECT_TRUE(ai.requestMove(WHITE, b) == m);
+
+    EXPECT_FALSE(ai.setBook("log/no_such_book.bin"));
+    EXPECT_TRUE(ai.setBook(""));
+    remove(path);
+}
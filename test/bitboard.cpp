@@ -0,0 +1,39 @@
+#include "../src/bitboard.h"
+
+#include "unit_test.h"
+
+TEST(Bitboard, SetOperations)
+{
+    Bitboard a = Bitboard::square(squareAt(0,0,0)) |
+                 Bitboard::square(squareAt(7,7,7));
+    Bitboard b = Bitboard::square(squareAt(7,7,7)) |
+                 Bitboard::square(squareAt(3,4,5));
+
+    EXPECT_EQ((a & b).count(), 1);
+    EXPECT_EQ((a | b).count(), 3);
+    EXPECT_EQ((a ^ b).count(), 2);
+    EXPECT_EQ((~a).count(), NUM_SQUARES - 2);
+    EXPECT_TRUE((a & ~a).empty());
+
+    EXPECT_TRUE(b.test(squareAt(3,4,5)));
+    b.clear(squareAt(3,4,5));
+    EXPECT_FALSE(b.test(squareAt(3,4,5)));
+
+    // Squares come out lowest first
+    EXPECT_EQ(a.popLowest(), squareAt(0,0,0));
+    EXPECT_EQ(a.popLowest(), squareAt(7,7,7));
+    EXPECT_TRUE(a.empty());
+}
+
+TEST(Bitboard, Shifts)
+{
+    Bitboard a = Bitboard::square(squareAt(2,3,0)) |
+                 Bitboard::square(squareAt(5,1,7));
+
+    // Moving up drops the top level, and vice versa
+    EXPECT_TRUE(a.up() == Bitboard::square(squareAt(2,3,1)));
+    EXPECT_TRUE(a.down() == Bitboard::square(squareAt(5,1,6)));
+
+    EXPECT_EQ(Bitboard::level(4).count(), 64);
+    EXPECT_TRUE(Bitboard::level(4).up() == Bitboard::level(5));
+}
@@ -76,11 +76,11 @@ TEST(Piece, Helpers)
 
 TEST(Move, Constructor)
 {
-    constructor_test(WHITE, QUIET, mailbox(4,4,5), mailbox(5,3,7));
-    constructor_test(WHITE, CAPTURE, mailbox(6,1,5), mailbox(4,3,3));
-    constructor_test(BLACK, EN_PASSANT, mailbox(2,3,3), mailbox(2,2,2));
-    constructor_test(BLACK, DOUBLE_PAWN_PUSH, mailbox(1,5,6), mailbox(1,5,4));
+    constructor_test(WHITE, QUIET, squareAt(4,4,5), squareAt(5,3,7));
+    constructor_test(WHITE, CAPTURE, squareAt(6,1,5), squareAt(4,3,3));
+    constructor_test(BLACK, EN_PASSANT, squareAt(2,3,3), squareAt(2,2,2));
+    constructor_test(BLACK, DOUBLE_PAWN_PUSH, squareAt(1,5,6), squareAt(1,5,4));
 
-    constructor_test(WHITE, PROMOTE, mailbox(1,4,6), mailbox(1,4,7), UNICORN);
-    constructor_test(BLACK, PROMO_CAPTURE, mailbox(4,2,1), mailbox(4,1,0), QUEEN);
+    constructor_test(WHITE, PROMOTE, squareAt(1,4,6), squareAt(1,4,7), UNICORN);
+    constructor_test(BLACK, PROMO_CAPTURE, squareAt(4,2,1), squareAt(4,1,0), QUEEN);
 }
@@ -0,0 +1,98 @@
+#include "../src/board.h"
+#include "../src/eval-params.h"
+#include "../src/evaluate.h"
+#include "../src/pawn-table.h"
+
+#include "unit_test.h"
+
+#include <algorithm>
+#include <cstdio>
+
+TEST(EvalParams, Names)
+{
+    EXPECT_STR_EQ(EvalParams::name(MATERIAL + KNIGHT).c_str(), "material.N");
+    EXPECT_STR_EQ(EvalParams::name(CENTER + W_PAWN).c_str(), "center.P");
+    EXPECT_STR_EQ(EvalParams::name(PASSED + 3).c_str(), "passed.3");
+    EXPECT_STR_EQ(EvalParams::name(BACKWARD).c_str(), "backward");
+
+    // The ones no piece uses have no name
+    EXPECT_STR_EQ(EvalParams::name(MATERIAL + NIL).c_str(), "");
+    EXPECT_STR_EQ(EvalParams::name(FILES + B_PAWN).c_str(), "");
+}
+
+TEST(EvalParams, SaveLoad)
+{
+    EvalParams params;
+    params.scores[MATERIAL + QUEEN] = Score(1500, 1700);
+    params.scores[DOUBLED] = Score(-3, -4);
+
+    const char* path = "log/eval_params_test.txt";
+    ASSERT_TRUE(params.save(path));
+
+    EvalParams loaded;
+    ASSERT_TRUE(loaded.load(path));
+    for(int param = 0; param < NUM_EVAL_PARAMS; param++)
+        EXPECT_TRUE(loaded.scores[param] == params.scores[param]);
+
+    // A line that isn't a parameter spoils the whole file
+    FILE* f = fopen(path, "a");
+    ASSERT_TRUE(f != NULL);
+    fprintf(f, "material.X 1 2\n");
+    fclose(f);
+
+    EvalParams defaults;
+    EXPECT_FALSE(defaults.load(path));
+    EXPECT_TRUE(defaults.scores[DOUBLED] == EvalParams().scores[DOUBLED]);
+
+    remove(path);
+}
+
+TEST(EvalParams, Trace)
+{
+    Board b;
+    b.setup();
+
+    // Along a game, the trace adds up to what the board and pawns score
+    for(int n = 0; n < 60; n++)
+    {
+        MoveList moves;
+        b.generateLegalMoves(b.whoseTurn(), moves);
+        if(moves.empty())
+            break;
+        b.makeMove(moves[(n * 7919) % moves.size()]);
+
+        EvalTrace trace;
+        traceEvaluation(b, trace);
+
+        PawnEntry entry;
+        evaluatePawns(b, entry);
+        Score expected = b.psqScore();
+        expected += entry.score;
+
+        ASSERT_TRUE(trace.score(evalParams()) == expected);
+        ASSERT_EQ(trace.phase, std::min(b.phase(), MAX_PHASE));
+    }
+}
+
+TEST(EvalParams, SetParams)
+{
+    // Removing a black pawn puts White ahead, by more once pawns are worth
+    // more
+    Board b;
+    b.setup();
+    b.putPiece(Piece(NIL, WHITE), squareAt(3,3,6));
+    int before = evaluate(b);
+    EXPECT_GT(before, 0);
+
+    EvalParams params;
+    params.scores[MATERIAL + W_PAWN] = Score(300, 300);
+    setEvalParams(params);
+
+    Board fresh;
+    fresh.setPosition(b.getPosition());
+    EXPECT_GT(evaluate(fresh), before);
+
+    setEvalParams(EvalParams());
+    fresh.setPosition(b.getPosition());
+    EXPECT_EQ(evaluate(fresh), before);
+}
@@ -0,0 +1,79 @@
+#include "../src/board.h"
+#include "../src/evaluate.h"
+#include "../src/piece-square.h"
+
+#include "unit_test.h"
+
+TEST(Evaluate, Setup)
+{
+    Board b;
+    b.setup();
+
+    // The setup is symmetric, so nobody is ahead
+    EXPECT_EQ(b.phase(), MAX_PHASE);
+    EXPECT_EQ(b.psqScore().mg, 0);
+    EXPECT_EQ(b.psqScore().eg, 0);
+    EXPECT_EQ(evaluate(b), 0);
+}
+
+TEST(Evaluate, Mirrored)
+{
+    // Black's tables are White's, with the levels flipped
+    for(int sq = 0; sq < NUM_SQUARES; sq++)
+    {
+        int flipped = squareAt(squareX(sq), squareY(sq), 7 - squareZ(sq));
+        const Score& white = PieceSquare::piece(Piece(KNIGHT, WHITE), sq);
+        const Score& black = PieceSquare::piece(Piece(KNIGHT, BLACK), flipped);
+        EXPECT_EQ(white.mg, -black.mg);
+        EXPECT_EQ(white.eg, -black.eg);
+
+        const Score& wp = PieceSquare::piece(Piece::Pawn(WHITE), sq);
+        const Score& bp = PieceSquare::piece(Piece::Pawn(BLACK), flipped);
+        EXPECT_EQ(wp.mg, -bp.mg);
+    }
+
+    // Pawns are worth more the further they've gone
+    Piece wp = Piece::Pawn(WHITE);
+    EXPECT_GT(PieceSquare::piece(wp, squareAt(3,3,5)).eg,
+              PieceSquare::piece(wp, squareAt(3,3,2)).eg);
+}
+
+TEST(Evaluate, Incremental)
+{
+    Board b;
+    b.setup();
+
+    // Play a game with captures and promotions, checking the running score
+    // against a board set up from scratch at each step
+    for(int n = 0; n < 120; n++)
+    {
+        MoveList moves;
+        b.generateLegalMoves(b.whoseTurn(), moves);
+        if(moves.empty())
+            break;
+
+        Move m = moves[(n * 7919) % moves.size()];
+        for(const Move* it = moves.begin(); it != moves.end(); it++)
+            if(it->isCapture() || it->type() == PROMOTE)
+                m = *it;
+        b.makeMove(m);
+
+        Board fresh;
+        fresh.setPosition(b.getPosition());
+        ASSERT_TRUE(b.psqScore() == fresh.psqScore());
+        ASSERT_EQ(b.phase(), fresh.phase());
+    }
+
+    // And undoing everything gets back to the start
+    int plies = b.getHistory().size();
+    for(int n = 0; n < plies; n++)
+        b.undoMove();
+    EXPECT_EQ(b.phase(), MAX_PHASE);
+    EXPECT_EQ(evaluate(b), 0);
+
+    // putPiece counts too: taking away one of Black's queens puts White
+    // (to move) ahead
+    b.putPiece(Piece(NIL, WHITE), squareAt(3,4,7));
+    EXPECT_EQ(b.phase(), MAX_PHASE - PieceSquare::phase(QUEEN));
+    EXPECT_GT(evaluate(b), 0);
+}
@@ -0,0 +1,42 @@
+#include "../src/geometry.h"
+
+#include "unit_test.h"
+
+TEST(Geometry, Steps)
+{
+    // Steps that would leave the board say so, instead of wrapping around
+    EXPECT_EQ(Geometry::step(squareAt(7,3,3), 0), OFF_BOARD);
+    EXPECT_EQ(Geometry::step(squareAt(6,3,3), 0), squareAt(7,3,3));
+    EXPECT_EQ(Geometry::step(squareAt(0,0,0), KNIGHT_OFFSETS), squareAt(2,1,0));
+}
+
+TEST(Geometry, Leaps)
+{
+    EXPECT_EQ(Geometry::leaps(KNIGHT, squareAt(0,0,0)).count(), 6);
+    EXPECT_EQ(Geometry::leaps(KING, squareAt(0,0,0)).count(), 7);
+    EXPECT_EQ(Geometry::leaps(KING, squareAt(3,3,3)).count(), 26);
+    EXPECT_EQ(Geometry::leaps(UNICORN, squareAt(3,3,3)).count(), 72);
+
+    // Pawns capture forward only, and not on the last rank
+    EXPECT_EQ(Geometry::leaps(W_PAWN, squareAt(3,3,1)).count(), 8);
+    EXPECT_TRUE(Geometry::leaps(W_PAWN, squareAt(3,3,7)).empty());
+    EXPECT_TRUE(Geometry::leaps(B_PAWN, squareAt(3,3,3)).test(squareAt(4,4,2)));
+}
+
+TEST(Geometry, Rays)
+{
+    // The +x ray from the corner covers the rest of the row
+    EXPECT_EQ(Geometry::ray(squareAt(0,0,0), 0).count(), 7);
+
+    Bitboard occupied = Bitboard::square(squareAt(0,0,4));
+
+    // Sliding stops on the first piece, in either direction along a line
+    Bitboard up = Geometry::slide(squareAt(0,0,0), 2, occupied);
+    Bitboard down = Geometry::slide(squareAt(0,0,7), 5, occupied);
+    EXPECT_EQ(up.count(), 4);
+    EXPECT_EQ(down.count(), 3);
+    EXPECT_TRUE(up.test(squareAt(0,0,4)));
+    EXPECT_TRUE(down.test(squareAt(0,0,4)));
+    EXPECT_EQ(Geometry::firstBlocker(squareAt(0,0,7), 5, occupied),
+            squareAt(0,0,4));
+}
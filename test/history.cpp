@@ -0,0 +1,61 @@
+#include "../src/common.h"
+#include "../src/history.h"
+
+#include "unit_test.h"
+
+TEST(History, Update)
+{
+    History history;
+    Move m (WHITE, QUIET, squareAt(1,2,3), squareAt(4,5,6));
+    EXPECT_EQ(history.score(m), 0);
+
+    history.update(m, 100);
+    EXPECT_EQ(history.score(m), 100);
+    history.update(m, -40);
+    EXPECT_LT(history.score(m), 100);
+    EXPECT_GT(history.score(m), 0);
+
+    // Moves are told apart by color, origin and target
+    EXPECT_EQ(history.score(Move(BLACK, QUIET, squareAt(1,2,3),
+            squareAt(4,5,6))), 0);
+    EXPECT_EQ(history.score(Move(WHITE, QUIET, squareAt(4,5,6),
+            squareAt(1,2,3))), 0);
+
+    // But not by type
+    EXPECT_EQ(history.score(Move(WHITE, DOUBLE_PAWN_PUSH, squareAt(1,2,3),
+            squareAt(4,5,6))), history.score(m));
+}
+
+TEST(History, Bounds)
+{
+    History history;
+    Move m (BLACK, QUIET, squareAt(7,7,7), squareAt(0,0,0));
+
+    // However many bonuses a move gets, its score stays in range
+    for(int i = 0; i < 1000; i++)
+    {
+        history.update(m, 5000);
+        ASSERT_LE(history.score(m), History::MAX_HISTORY);
+    }
+    EXPECT_GT(history.score(m), History::MAX_HISTORY / 2);
+
+    for(int i = 0; i < 1000; i++)
+    {
+        history.update(m, -100000);
+        ASSERT_GE(history.score(m), -History::MAX_HISTORY);
+    }
+    EXPECT_EQ(history.score(m), -History::MAX_HISTORY);
+}
+
+TEST(History, Age)
+{
+    History history;
+    Move m (WHITE, QUIET, squareAt(0,0,0), squareAt(0,0,1));
+    history.update(m, 1000);
+
+    history.age();
+    EXPECT_EQ(history.score(m), 500);
+
+    history.clear();
+    EXPECT_EQ(history.score(m), 0);
+}
@@ -1,4 +1,5 @@
 #include "../src/board.h"
+#include "../src/geometry.h"
 
 #include "unit_test.h"
 
@@ -14,17 +15,17 @@ using std::stringstream;
  * Given a list of moves, this takes all their targets and converts them to
  * strings of the form "(x, y, z)".
  */
-list<string> stringifyTargets(const list<Move>& moves)
+list<string> stringifyTargets(const MoveList& moves)
 {
     list<string> strs;
 
-    list<Move>::const_iterator it;
+    const Move* it;
     for(it = moves.begin(); it != moves.end(); it++)
     {
         stringstream ss;
         int i = it->target();
-        ss << "(" << unmailboxX(i) << ", " << unmailboxY(i) << ", " <<
-                unmailboxZ(i) << ")";
+        ss << "(" << squareX(i) << ", " << squareY(i) << ", " <<
+                squareZ(i) << ")";
         strs.push_back(ss.str());
     }
     
@@ -58,7 +59,9 @@ void matchQuietMoves(PieceType pt, int origin, int targets [], int num_targets)
     }
 
     // Convert move array to string representing target coordinates
-    from_list = stringifyTargets(b.generateMoves(origin));
+    MoveList moves;
+    b.generateMoves(origin, moves);
+    from_list = stringifyTargets(moves);
 
     // Sorts both arrays so that we just need to check equality now
     from_array.sort();
@@ -87,20 +90,19 @@ void testCompoundPiece(PieceType pt, PieceType parts [], int num_parts,
         int origin)
 {
     Board b;
-    list<Move> compoundMoves;
-    list<Move> componentMoves;
+    MoveList compoundMoves;
+    MoveList componentMoves;
 
     // Generates moves from the compound piece
     b.putPiece(Piece(pt, WHITE), origin);
-    compoundMoves = b.generateMoves(origin);
+    b.generateMoves(origin, compoundMoves);
 
     // Puts down one piece, generates moves, then replaces it with another
     // piece, and appends those moves, ...
     for(int i = 0; i < num_parts; i++)
     {
         b.putPiece(Piece(parts[i], WHITE), origin);
-        list<Move> temp = b.generateMoves(origin);
-        componentMoves.splice(componentMoves.end(), temp);
+        b.generateMoves(origin, componentMoves);
     }
 
     list<string> compoundStrs = stringifyTargets(compoundMoves);
@@ -118,10 +120,9 @@ void testCompoundPiece(PieceType pt, PieceType parts [], int num_parts,
 /**
  * Returns true if the given list contains the given move.
  */
-bool containsMove(const list<Move>& li, Move m)
+bool containsMove(const MoveList& li, Move m)
 {
-    list<Move>::const_iterator it = find(li.begin(), li.end(), m);
-    return (it != li.end());
+    return li.contains(m);
 }
 
 /*
@@ -140,7 +141,7 @@ TEST(MoveGeneration, Knight)
         2,4,6, 2,5,5, 3,3,6, 3,5,4, 4,3,5, 4,4,4  // + +
     };
 
-    matchQuietMoves(KNIGHT, mailbox(2,3,4), array, 24);
+    matchQuietMoves(KNIGHT, squareAt(2,3,4), array, 24);
 }
 
 TEST(MoveGeneration, Griffin)
@@ -152,7 +153,7 @@ TEST(MoveGeneration, Griffin)
         0,2,3, 0,2,5, 0,4,3, 0,4,5, 4,2,3, 4,2,5, 4,4,3, 4,4,5  // 2 2 1
     };
 
-    matchQuietMoves(GRIFFIN, mailbox(2,3,4), array, 24);
+    matchQuietMoves(GRIFFIN, squareAt(2,3,4), array, 24);
 }
 
 TEST(MoveGeneration, Dragon)
@@ -164,13 +165,13 @@ TEST(MoveGeneration, Dragon)
         0,1,3, 0,1,5, 0,5,3, 0,5,5, 4,1,3, 4,1,5, 4,5,3, 4,5,5  // 2 2 1
     };
 
-    matchQuietMoves(DRAGON, mailbox(2,3,4), array, 24);
+    matchQuietMoves(DRAGON, squareAt(2,3,4), array, 24);
 }
 
 TEST(MoveGeneration, Unicorn)
 {
     PieceType array [] = {KNIGHT, GRIFFIN, DRAGON};
-    testCompoundPiece(UNICORN, array, 3, mailbox(2,3,4));
+    testCompoundPiece(UNICORN, array, 3, squareAt(2,3,4));
 }
 
 TEST(MoveGeneration, Rook)
@@ -181,7 +182,7 @@ TEST(MoveGeneration, Rook)
         0,3,4, 1,3,4,        3,3,4, 4,3,4, 5,3,4, 6,3,4, 7,3,4  // + 0 0
     };
 
-    matchQuietMoves(ROOK, mailbox(2,3,4), array, 21);
+    matchQuietMoves(ROOK, squareAt(2,3,4), array, 21);
 }
 
 TEST(MoveGeneration, Bishop)
@@ -195,7 +196,7 @@ TEST(MoveGeneration, Bishop)
         2,0,7, 2,1,6, 2,2,5,        2,4,3, 2,5,2, 2,6,1, 2,7,0 // 0 + -
     };
 
-    matchQuietMoves(BISHOP, mailbox(2,3,4), array, 35);
+    matchQuietMoves(BISHOP, squareAt(2,3,4), array, 35);
 }
 
 TEST(MoveGeneration, Mace)
@@ -207,31 +208,31 @@ TEST(MoveGeneration, Mace)
         0,5,6, 1,4,5,        3,2,3, 4,1,2, 5,0,1         // + - -
     };
 
-    matchQuietMoves(MACE, mailbox(2,3,4), array, 21);
+    matchQuietMoves(MACE, squareAt(2,3,4), array, 21);
 }
 
 TEST(MoveGeneration, Wizard)
 {
     PieceType array [] = {ROOK, BISHOP};
-    testCompoundPiece(WIZARD, array, 2, mailbox(2,3,4));
+    testCompoundPiece(WIZARD, array, 2, squareAt(2,3,4));
 }
 
 TEST(MoveGeneration, Archer)
 {
     PieceType array [] = {BISHOP, MACE};
-    testCompoundPiece(ARCHER, array, 2, mailbox(2,3,4));
+    testCompoundPiece(ARCHER, array, 2, squareAt(2,3,4));
 }
 
 TEST(MoveGeneration, Cannon)
 {
     PieceType array [] = {ROOK, MACE};
-    testCompoundPiece(CANNON, array, 2, mailbox(2,3,4));
+    testCompoundPiece(CANNON, array, 2, squareAt(2,3,4));
 }
 
 TEST(MoveGeneration, Queen)
 {
     PieceType array [] = {ROOK, BISHOP, MACE};
-    testCompoundPiece(QUEEN, array, 3, mailbox(2,3,4));
+    testCompoundPiece(QUEEN, array, 3, squareAt(2,3,4));
 }
 
 TEST(MoveGeneration, King)
@@ -244,7 +245,23 @@ TEST(MoveGeneration, King)
     //  0 - 0  0 0 0  0 + 0  0 - 0  0 0 0  0 + 0  0 - 0  0 0 0  0 + 0
     };
 
-    matchQuietMoves(KING, mailbox(2,3,4), array, 26);
+    matchQuietMoves(KING, squareAt(2,3,4), array, 26);
+}
+
+// Pieces in a corner have the fewest moves, and must not wrap around
+TEST(MoveGeneration, Corner)
+{
+    int knight [] = {
+        5,6,7, 6,5,7, 5,7,6, 7,5,6, 6,7,5, 7,6,5
+    };
+    matchQuietMoves(KNIGHT, squareAt(7,7,7), knight, 6);
+
+    int rook [] = {
+        1,0,0, 2,0,0, 3,0,0, 4,0,0, 5,0,0, 6,0,0, 7,0,0,
+        0,1,0, 0,2,0, 0,3,0, 0,4,0, 0,5,0, 0,6,0, 0,7,0,
+        0,0,1, 0,0,2, 0,0,3, 0,0,4, 0,0,5, 0,0,6, 0,0,7
+    };
+    matchQuietMoves(ROOK, squareAt(0,0,0), rook, 21);
 }
 
 // Next come several pawn tests
@@ -267,57 +284,58 @@ TEST(MoveGeneration, PawnII)
     Board b;
     Piece wp (W_PAWN, WHITE);
     Piece bp (B_PAWN, BLACK);
-    int i = mailbox(2,3,1);
-    int j = mailbox(2,3,6);
+    int i = squareAt(2,3,1);
+    int j = squareAt(2,3,6);
 
     // Put down pawns
     b.putPiece(wp, i);
     b.putPiece(bp, j);
 
     // Put down capture targets (also pawns)
-    b.putPiece(bp, mailbox(1,2,2));
-    b.putPiece(bp, mailbox(1,3,2));
-    b.putPiece(bp, mailbox(1,4,2));
-    b.putPiece(bp, mailbox(2,2,2));
-    b.putPiece(bp, mailbox(2,4,2));
-    b.putPiece(bp, mailbox(3,2,2));
-    b.putPiece(bp, mailbox(3,3,2));
-    b.putPiece(bp, mailbox(3,4,2));
-
-    b.putPiece(wp, mailbox(1,2,5));
-    b.putPiece(wp, mailbox(1,3,5));
-    b.putPiece(wp, mailbox(1,4,5));
-    b.putPiece(wp, mailbox(2,2,5));
-    b.putPiece(wp, mailbox(2,4,5));
-    b.putPiece(wp, mailbox(3,2,5));
-    b.putPiece(wp, mailbox(3,3,5));
-    b.putPiece(wp, mailbox(3,4,5));
+    b.putPiece(bp, squareAt(1,2,2));
+    b.putPiece(bp, squareAt(1,3,2));
+    b.putPiece(bp, squareAt(1,4,2));
+    b.putPiece(bp, squareAt(2,2,2));
+    b.putPiece(bp, squareAt(2,4,2));
+    b.putPiece(bp, squareAt(3,2,2));
+    b.putPiece(bp, squareAt(3,3,2));
+    b.putPiece(bp, squareAt(3,4,2));
+
+    b.putPiece(wp, squareAt(1,2,5));
+    b.putPiece(wp, squareAt(1,3,5));
+    b.putPiece(wp, squareAt(1,4,5));
+    b.putPiece(wp, squareAt(2,2,5));
+    b.putPiece(wp, squareAt(2,4,5));
+    b.putPiece(wp, squareAt(3,2,5));
+    b.putPiece(wp, squareAt(3,3,5));
+    b.putPiece(wp, squareAt(3,4,5));
 
     // Generate movelists and check their contents
-    list<Move> w_moves = b.generateMoves(i);
-    list<Move> b_moves = b.generateMoves(j);
-
-    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, QUIET, i, mailbox(2,3,2))));
-    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, DOUBLE_PAWN_PUSH, i, mailbox(2,3,3))));
-    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, mailbox(1,2,2))));
-    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, mailbox(1,3,2))));
-    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, mailbox(1,4,2))));
-    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, mailbox(2,2,2))));
-    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, mailbox(2,4,2))));
-    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, mailbox(3,2,2))));
-    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, mailbox(3,3,2))));
-    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, mailbox(3,4,2))));
-
-    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, QUIET,   j, mailbox(2,3,5))));
-    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, DOUBLE_PAWN_PUSH, j, mailbox(2,3,4))));
-    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, mailbox(1,2,5))));
-    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, mailbox(1,3,5))));
-    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, mailbox(1,4,5))));
-    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, mailbox(2,2,5))));
-    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, mailbox(2,4,5))));
-    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, mailbox(3,2,5))));
-    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, mailbox(3,3,5))));
-    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, mailbox(3,4,5))));
+    MoveList w_moves, b_moves;
+    b.generateMoves(i, w_moves);
+    b.generateMoves(j, b_moves);
+
+    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, QUIET, i, squareAt(2,3,2))));
+    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, DOUBLE_PAWN_PUSH, i, squareAt(2,3,3))));
+    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, squareAt(1,2,2))));
+    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, squareAt(1,3,2))));
+    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, squareAt(1,4,2))));
+    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, squareAt(2,2,2))));
+    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, squareAt(2,4,2))));
+    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, squareAt(3,2,2))));
+    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, squareAt(3,3,2))));
+    EXPECT_TRUE(containsMove(w_moves, Move(WHITE, CAPTURE, i, squareAt(3,4,2))));
+
+    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, QUIET,   j, squareAt(2,3,5))));
+    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, DOUBLE_PAWN_PUSH, j, squareAt(2,3,4))));
+    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, squareAt(1,2,5))));
+    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, squareAt(1,3,5))));
+    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, squareAt(1,4,5))));
+    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, squareAt(2,2,5))));
+    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, squareAt(2,4,5))));
+    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, squareAt(3,2,5))));
+    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, squareAt(3,3,5))));
+    EXPECT_TRUE(containsMove(b_moves, Move(BLACK, CAPTURE, j, squareAt(3,4,5))));
 
     // Confirms that there are no other moves in the lists
     EXPECT_EQ(w_moves.size(), 10);
@@ -348,14 +366,14 @@ TEST(MoveGeneration, PawnI)
 
     Board board;
     Piece wp (W_PAWN, WHITE);
-    list<Move> moves;
+    MoveList moves;
 
-    int a = mailbox(2,0,7);
-    int b = mailbox(3,0,1);
-    int c = mailbox(3,0,3);
-    int d = mailbox(6,0,3);
-    int e = mailbox(7,0,1);
-    int f = mailbox(7,0,2);
+    int a = squareAt(2,0,7);
+    int b = squareAt(3,0,1);
+    int c = squareAt(3,0,3);
+    int d = squareAt(6,0,3);
+    int e = squareAt(7,0,1);
+    int f = squareAt(7,0,2);
 
     board.putPiece(wp, a);
     board.putPiece(wp, b);
@@ -365,32 +383,39 @@ TEST(MoveGeneration, PawnI)
     board.putPiece(wp, f);
 
     // Pawns cannot move off the board
-    moves = board.generateMoves(a);
-    EXPECT_FALSE(containsMove(moves, Move(WHITE, QUIET, a, mailbox(2,0,8))));
+    moves.clear();
+    board.generateMoves(a, moves);
+    EXPECT_TRUE(moves.empty());
 
     // Pawns cannot move forward twice if that square is non-empty
-    moves = board.generateMoves(b);
-    EXPECT_FALSE(containsMove(moves, Move(WHITE, DOUBLE_PAWN_PUSH, b, mailbox(3,0,3))));
+    moves.clear();
+    board.generateMoves(b, moves);
+    EXPECT_FALSE(containsMove(moves, Move(WHITE, DOUBLE_PAWN_PUSH, b, squareAt(3,0,3))));
     // but they can move forward once
-    EXPECT_TRUE(containsMove(moves, Move(WHITE, QUIET, b, mailbox(3,0,2))));
+    EXPECT_TRUE(containsMove(moves, Move(WHITE, QUIET, b, squareAt(3,0,2))));
 
     // Pawns cannot move forward twice if they are off their home rank
-    moves = board.generateMoves(c);
-    EXPECT_FALSE(containsMove(moves, Move(WHITE, DOUBLE_PAWN_PUSH, c, mailbox(3,0,5))));
+    moves.clear();
+    board.generateMoves(c, moves);
+    EXPECT_FALSE(containsMove(moves, Move(WHITE, DOUBLE_PAWN_PUSH, c, squareAt(3,0,5))));
     // once more, for good measure (and because D doesn't do anything else)
-    moves = board.generateMoves(d);
-    EXPECT_FALSE(containsMove(moves, Move(WHITE, DOUBLE_PAWN_PUSH, d, mailbox(6,0,5))));
+    moves.clear();
+    board.generateMoves(d, moves);
+    EXPECT_FALSE(containsMove(moves, Move(WHITE, DOUBLE_PAWN_PUSH, d, squareAt(6,0,5))));
 
     // Pawns cannot move forward at all if they are immediately obstructed
-    moves = board.generateMoves(e);
-    EXPECT_FALSE(containsMove(moves, Move(WHITE, QUIET, e, mailbox(7,0,2))));
-    EXPECT_FALSE(containsMove(moves, Move(WHITE, DOUBLE_PAWN_PUSH, e, mailbox(7,0,3))));
-
-    // Pawns cannot capture their teammates, nil spaces, or borders
-    moves = board.generateMoves(f);
-    EXPECT_FALSE(containsMove(moves, Move(WHITE, CAPTURE, f, mailbox(6,0,3))));
-    EXPECT_FALSE(containsMove(moves, Move(WHITE, CAPTURE, f, mailbox(7,1,3))));
-    EXPECT_FALSE(containsMove(moves, Move(WHITE, CAPTURE, f, mailbox(8,0,3))));
+    moves.clear();
+    board.generateMoves(e, moves);
+    EXPECT_FALSE(containsMove(moves, Move(WHITE, QUIET, e, squareAt(7,0,2))));
+    EXPECT_FALSE(containsMove(moves, Move(WHITE, DOUBLE_PAWN_PUSH, e, squareAt(7,0,3))));
+
+    // Pawns cannot capture their teammates or nil spaces, or wrap around the
+    // edge of the board
+    moves.clear();
+    board.generateMoves(f, moves);
+    EXPECT_FALSE(containsMove(moves, Move(WHITE, CAPTURE, f, squareAt(6,0,3))));
+    EXPECT_FALSE(containsMove(moves, Move(WHITE, CAPTURE, f, squareAt(7,1,3))));
+    EXPECT_FALSE(containsMove(moves, Move(WHITE, CAPTURE, f, squareAt(0,1,3))));
 }
 
 /** Tests that promotions and promo-captures behave correctly. */
@@ -399,14 +424,15 @@ TEST(MoveGeneration, PromoMaybeCapture)
     Board b;
     Piece wp (W_PAWN, WHITE);
     Piece br (ROOK, BLACK);
-    int i = mailbox(1,4,6);
-    int j = mailbox(1,4,7);
-    int k = mailbox(1,5,7);
-    list<Move> moves;
+    int i = squareAt(1,4,6);
+    int j = squareAt(1,4,7);
+    int k = squareAt(1,5,7);
+    MoveList moves;
 
     // Nothing in the way? Promotions only.
     b.putPiece(wp, i);
-    moves = b.generateMoves(i);
+    moves.clear();
+    b.generateMoves(i, moves);
     EXPECT_EQ((signed) moves.size(), NUM_PROMOTION_PIECES);
     for(int t = 0; t < NUM_PROMOTION_PIECES; t++)
     {
@@ -416,12 +442,14 @@ TEST(MoveGeneration, PromoMaybeCapture)
 
     // Add an obstruction? Nothing to do here.
     b.putPiece(br, j);
-    moves = b.generateMoves(i);
+    moves.clear();
+    b.generateMoves(i, moves);
     EXPECT_EQ(moves.size(), 0);
 
     // Add something to capture? Promo-captures only.
     b.putPiece(br, k);
-    moves = b.generateMoves(i);
+    moves.clear();
+    b.generateMoves(i, moves);
     EXPECT_EQ((signed) moves.size(), NUM_PROMOTION_PIECES);
     for(int t = 0; t < NUM_PROMOTION_PIECES; t++)
     {
@@ -431,7 +459,8 @@ TEST(MoveGeneration, PromoMaybeCapture)
 
     // Remove the obstruction? Both types of moves.
     b.putPiece(Piece(NIL, WHITE), j);
-    moves = b.generateMoves(i);
+    moves.clear();
+    b.generateMoves(i, moves);
     EXPECT_EQ((signed) moves.size(), 2 * NUM_PROMOTION_PIECES);
     for(int t = 0; t < NUM_PROMOTION_PIECES; t++)
     {
@@ -452,32 +481,34 @@ TEST(MoveGeneration, Capture)
     Piece wr (ROOK, WHITE);
     Piece bn (KNIGHT, BLACK);
     Piece wp (W_PAWN, WHITE);
-    int i = mailbox(2,3,4);
-    int j = mailbox(4,3,4);
-    int k = mailbox(2,2,4);
+    int i = squareAt(2,3,4);
+    int j = squareAt(4,3,4);
+    int k = squareAt(2,2,4);
 
     // Put down the rook, knight, and pawn
     b.putPiece(wr, i);
     b.putPiece(bn, j);
     b.putPiece(wp, k);
 
-    list<Move> moves = b.generateMoves(i);
+    MoveList moves;
+    b.generateMoves(i, moves);
 
     // Rook can still move toward the knight
-    EXPECT_TRUE(containsMove(moves, Move(WHITE, QUIET, i, mailbox(3,3,4))));
+    EXPECT_TRUE(containsMove(moves, Move(WHITE, QUIET, i, squareAt(3,3,4))));
 
     // Can't move onto the knight, but can capture it
     EXPECT_FALSE(containsMove(moves, Move(WHITE, QUIET, i, j)));
     EXPECT_TRUE(containsMove(moves, Move(WHITE, CAPTURE, i, j)));
 
     // Can't move past it
-    EXPECT_FALSE(containsMove(moves, Move(WHITE, QUIET, i, mailbox(5,3,4))));
+    EXPECT_FALSE(containsMove(moves, Move(WHITE, QUIET, i, squareAt(5,3,4))));
 
     // It also can't capture the pawn
     EXPECT_FALSE(containsMove(moves, Move(WHITE, CAPTURE, i, k)));
 
     // Knight can capture the pawn
-    moves = b.generateMoves(j);
+    moves.clear();
+    b.generateMoves(j, moves);
     EXPECT_TRUE(containsMove(moves, Move(BLACK, CAPTURE, j, k)));
 }
 
@@ -496,14 +527,14 @@ TEST(MoveGeneration, EnPassant)
      * +---------------+
      *   0 1 2 3 4 5 6
      */
-    int a = mailbox(1,0,6);
-    int b = mailbox(1,0,5);
-    int c = mailbox(1,0,4);
-    int d = mailbox(2,0,4);
-    int e = mailbox(4,0,6);
-    int f = mailbox(4,0,4);
-    int g = mailbox(6,0,4);
-    int h = mailbox(6,0,5);
+    int a = squareAt(1,0,6);
+    int b = squareAt(1,0,5);
+    int c = squareAt(1,0,4);
+    int d = squareAt(2,0,4);
+    int e = squareAt(4,0,6);
+    int f = squareAt(4,0,4);
+    int g = squareAt(6,0,4);
+    int h = squareAt(6,0,5);
 
     // Because the ability to perform en passant is triggered by another move,
     // we have to execute a sequence of moves.
@@ -518,11 +549,12 @@ TEST(MoveGeneration, EnPassant)
     board.putPiece(bp, e);
     board.putPiece(wp, h);
 
-    list<Move> moves;
+    MoveList moves;
 
     // After the first move,
     board.makeMove(first);
-    moves = board.generatePseudoLegalMoves(WHITE);
+    moves.clear();
+    board.generatePseudoLegalMoves(WHITE, moves);
     // D can perform en passant, because it's diagonal to the target square,
     EXPECT_TRUE(containsMove(moves, Move(WHITE, EN_PASSANT, d, b)));
     // But H can't, because it isn't.
@@ -531,7 +563,8 @@ TEST(MoveGeneration, EnPassant)
     // Do two more moves (doesn't really matter which)
     board.makeMove(second);
     board.makeMove(third);
-    moves = board.generateMoves(d);
+    moves.clear();
+    board.generateMoves(d, moves);
     // D lost the chance to do en passant
     EXPECT_FALSE(containsMove(moves, Move(WHITE, EN_PASSANT, d, b)));
 }
@@ -545,36 +578,76 @@ TEST(MoveGeneration, Castle)
     // This bishop will block a castling path next turn
     Piece bb (BISHOP, BLACK);
     // King square
-    int i = mailbox(4,4,0);
+    int i = squareAt(4,4,0);
 
     Board b;
     b.putPiece(wk, i);
-    b.putPiece(wr, mailbox(0,4,0));
-    b.putPiece(wr, mailbox(7,4,0));
-    b.putPiece(wr, mailbox(4,0,0));
-    b.putPiece(wr, mailbox(4,7,0));
-    b.putPiece(ww, mailbox(0,0,0));
-    b.putPiece(ww, mailbox(7,7,0));
-    b.putPiece(bb, mailbox(5,2,0));
+    b.putPiece(wr, squareAt(0,4,0));
+    b.putPiece(wr, squareAt(7,4,0));
+    b.putPiece(wr, squareAt(4,0,0));
+    b.putPiece(wr, squareAt(4,7,0));
+    b.putPiece(ww, squareAt(0,0,0));
+    b.putPiece(ww, squareAt(7,7,0));
+    b.putPiece(bb, squareAt(5,2,0));
 
     // Should be able to castle everywhere
-    list<Move> moves = b.generateCastlingMoves(WHITE);
+    MoveList moves;
+    b.generateCastlingMoves(WHITE, moves);
     EXPECT_EQ(moves.size(), 6);
-    EXPECT_TRUE(containsMove(moves, Move(WHITE, CASTLE, i, mailbox(2,4,0))));
-    EXPECT_TRUE(containsMove(moves, Move(WHITE, CASTLE, i, mailbox(6,4,0))));
-    EXPECT_TRUE(containsMove(moves, Move(WHITE, CASTLE, i, mailbox(4,2,0))));
-    EXPECT_TRUE(containsMove(moves, Move(WHITE, CASTLE, i, mailbox(4,6,0))));
-    EXPECT_TRUE(containsMove(moves, Move(WHITE, CASTLE, i, mailbox(2,2,0))));
-    EXPECT_TRUE(containsMove(moves, Move(WHITE, CASTLE, i, mailbox(6,6,0))));
+    EXPECT_TRUE(containsMove(moves, Move(WHITE, CASTLE, i, squareAt(2,4,0))));
+    EXPECT_TRUE(containsMove(moves, Move(WHITE, CASTLE, i, squareAt(6,4,0))));
+    EXPECT_TRUE(containsMove(moves, Move(WHITE, CASTLE, i, squareAt(4,2,0))));
+    EXPECT_TRUE(containsMove(moves, Move(WHITE, CASTLE, i, squareAt(4,6,0))));
+    EXPECT_TRUE(containsMove(moves, Move(WHITE, CASTLE, i, squareAt(2,2,0))));
+    EXPECT_TRUE(containsMove(moves, Move(WHITE, CASTLE, i, squareAt(6,6,0))));
 
     // One of the rooks moves, losing castling rights
-    b.makeMove(Move(WHITE, QUIET, mailbox(0,4,0), mailbox(0,4,2)));
+    b.makeMove(Move(WHITE, QUIET, squareAt(0,4,0), squareAt(0,4,2)));
     // Black bishop moves into the way of another rook
-    b.makeMove(Move(BLACK, QUIET, mailbox(5,2,0), mailbox(4,1,0)));
+    b.makeMove(Move(BLACK, QUIET, squareAt(5,2,0), squareAt(4,1,0)));
     // The rook moves back to its original spot
-    b.makeMove(Move(WHITE, QUIET, mailbox(0,4,2), mailbox(0,4,0)));
+    b.makeMove(Move(WHITE, QUIET, squareAt(0,4,2), squareAt(0,4,0)));
 
     // But we should only be able to castle to 4 places now
-    moves = b.generateCastlingMoves(WHITE);
+    moves.clear();
+    b.generateCastlingMoves(WHITE, moves);
     EXPECT_EQ(moves.size(), 4);
 }
+
+TEST(MoveGeneration, MostMoves)
+{
+    // MAX_MOVES is worked out from these, so they mustn't grow. Pawns get
+    // something to capture everywhere they can.
+    for(int t = W_PAWN; t <= KING; t++)
+    {
+        // Black's pawns are White's, mirrored
+        if(t == B_PAWN)
+            continue;
+
+        int most = 0;
+        for(int sq = 0; sq < NUM_SQUARES; sq++)
+        {
+            Board b;
+            b.putPiece(Piece((PieceType) t, WHITE), sq);
+            if(t == W_PAWN)
+            {
+                Bitboard captures = Geometry::leaps(W_PAWN, sq);
+                while(!captures.empty())
+                    b.putPiece(Piece(KNIGHT, BLACK), captures.popLowest());
+            }
+
+            MoveList moves;
+            b.generatePseudoLegalMoves(WHITE, moves);
+            most = std::max(most, moves.size());
+        }
+
+        if(t == W_PAWN)
+        {
+            EXPECT_EQ(most, 9 * NUM_PROMOTION_PIECES);
+        }
+        else
+        {
+            EXPECT_LE(most, 85);
+        }
+    }
+}
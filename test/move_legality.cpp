@@ -11,15 +11,15 @@ TEST(MoveLegality, Check)
     Piece bk (KING, BLACK);
 
     Board b;
-    b.putPiece(wk, mailbox(4,2,1));
-    b.putPiece(br, mailbox(4,2,5));
+    b.putPiece(wk, squareAt(4,2,1));
+    b.putPiece(br, squareAt(4,2,5));
 
     // The rook can attack the king
     EXPECT_TRUE(b.isInCheck(WHITE));
 
     // Put the knight in the way
-    b.putPiece(wn, mailbox(4,2,4));
-    b.putPiece(bk, mailbox(4,3,6));
+    b.putPiece(wn, squareAt(4,2,4));
+    b.putPiece(bk, squareAt(4,3,6));
 
     // So White is no longer in check, but Black is now
     EXPECT_TRUE(b.isInCheck(BLACK));
@@ -34,22 +34,22 @@ TEST(MoveLegality, Pin)
     Piece bw (WIZARD, BLACK);
 
     Board b;
-    b.putPiece(wk, mailbox(4,4,0));
-    b.putPiece(wr, mailbox(4,4,1));
-    b.putPiece(bw, mailbox(4,4,3));
+    b.putPiece(wk, squareAt(4,4,0));
+    b.putPiece(wr, squareAt(4,4,1));
+    b.putPiece(bw, squareAt(4,4,3));
 
     Move m;
 
     // The rook cannot move out of the way
-    m = Move(WHITE, QUIET, mailbox(4,4,1), mailbox(4,0,1));
+    m = Move(WHITE, QUIET, squareAt(4,4,1), squareAt(4,0,1));
     EXPECT_FALSE(b.isLegalMove(m));
 
     // The rook can move along the pin
-    m = Move(WHITE, QUIET, mailbox(4,4,1), mailbox(4,4,2));
+    m = Move(WHITE, QUIET, squareAt(4,4,1), squareAt(4,4,2));
     EXPECT_TRUE(b.isLegalMove(m));
 
     // The king can move out of the way
-    m = Move(WHITE, QUIET, mailbox(4,4,0), mailbox(4,3,0));
+    m = Move(WHITE, QUIET, squareAt(4,4,0), squareAt(4,3,0));
     EXPECT_TRUE(b.isLegalMove(m));
 }
 
@@ -61,26 +61,26 @@ TEST(MoveLegality, Block)
     Piece wr (ROOK, WHITE);
 
     Board b;
-    b.putPiece(bk, mailbox(4,4,7));
-    b.putPiece(bb, mailbox(4,5,6));
-    b.putPiece(wr, mailbox(4,4,3));
+    b.putPiece(bk, squareAt(4,4,7));
+    b.putPiece(bb, squareAt(4,5,6));
+    b.putPiece(wr, squareAt(4,4,3));
 
     Move m;
 
     // The bishop can block
-    m = Move(BLACK, QUIET, mailbox(4,5,6), mailbox(4,4,5));
+    m = Move(BLACK, QUIET, squareAt(4,5,6), squareAt(4,4,5));
     EXPECT_TRUE(b.isLegalMove(m));
 
     // The bishop can't move anywhere else though
-    m = Move(BLACK, QUIET, mailbox(4,5,6), mailbox(4,6,7));
+    m = Move(BLACK, QUIET, squareAt(4,5,6), squareAt(4,6,7));
     EXPECT_FALSE(b.isLegalMove(m));
 
     // The king can move out of the way
-    m = Move(BLACK, QUIET, mailbox(4,4,7), mailbox(4,3,7));
+    m = Move(BLACK, QUIET, squareAt(4,4,7), squareAt(4,3,7));
     EXPECT_TRUE(b.isLegalMove(m));
 
     // But not along the attack
-    m = Move(BLACK, QUIET, mailbox(4,4,7), mailbox(4,4,6));
+    m = Move(BLACK, QUIET, squareAt(4,4,7), squareAt(4,4,6));
     EXPECT_FALSE(b.isLegalMove(m));
 }
 
@@ -92,26 +92,197 @@ TEST(MoveLegality, Castle)
     Piece br (ROOK, BLACK);
 
     Board b;
-    b.putPiece(wk, mailbox(4,4,0));
-    b.putPiece(wr, mailbox(4,0,0));
-    b.putPiece(br, mailbox(4,1,3));
+    b.putPiece(wk, squareAt(4,4,0));
+    b.putPiece(wr, squareAt(4,0,0));
+    b.putPiece(br, squareAt(4,1,3));
 
     // Castling can occur even if the rook passes through check
-    Move m (WHITE, CASTLE, mailbox(4,4,0), mailbox(4,2,0));
+    Move m (WHITE, CASTLE, squareAt(4,4,0), squareAt(4,2,0));
     EXPECT_TRUE(b.isLegalMove(m));
 
     // But not if the king moves into check
-    b.makeMove(Move(BLACK, QUIET, mailbox(4,1,3), mailbox(4,2,3)));
+    b.makeMove(Move(BLACK, QUIET, squareAt(4,1,3), squareAt(4,2,3)));
     EXPECT_FALSE(b.isLegalMove(m));
     b.undoMove();
 
     // Or through check
-    b.makeMove(Move(BLACK, QUIET, mailbox(4,1,3), mailbox(4,3,3)));
+    b.makeMove(Move(BLACK, QUIET, squareAt(4,1,3), squareAt(4,3,3)));
     EXPECT_FALSE(b.isLegalMove(m));
     b.undoMove();
 
     // Or out of check
-    b.makeMove(Move(BLACK, QUIET, mailbox(4,1,3), mailbox(4,4,3)));
+    b.makeMove(Move(BLACK, QUIET, squareAt(4,1,3), squareAt(4,4,3)));
     EXPECT_FALSE(b.isLegalMove(m));
     b.undoMove();
 }
+
+TEST(MoveLegality, Attacked)
+{
+    Board b;
+    int sq = squareAt(3,3,3);
+
+    // Nothing is attacked on an empty board
+    EXPECT_FALSE(b.isSquareAttacked(sq, WHITE));
+    EXPECT_FALSE(b.isSquareAttacked(sq, BLACK));
+
+    // Pawns only attack forward
+    b.putPiece(Piece::Pawn(WHITE), squareAt(2,3,2));
+    EXPECT_TRUE(b.isSquareAttacked(sq, WHITE));
+    b.putPiece(Piece(NIL, WHITE), squareAt(2,3,2));
+    b.putPiece(Piece::Pawn(WHITE), squareAt(2,3,4));
+    EXPECT_FALSE(b.isSquareAttacked(sq, WHITE));
+    b.putPiece(Piece(NIL, WHITE), squareAt(2,3,4));
+
+    // Leapers, including the unicorn, which leaps like all of them
+    b.putPiece(Piece(DRAGON, BLACK), squareAt(5,4,5));
+    EXPECT_TRUE(b.isSquareAttacked(sq, BLACK));
+    b.putPiece(Piece(UNICORN, BLACK), squareAt(5,4,5));
+    EXPECT_TRUE(b.isSquareAttacked(sq, BLACK));
+    b.putPiece(Piece(KNIGHT, BLACK), squareAt(5,4,5));
+    EXPECT_FALSE(b.isSquareAttacked(sq, BLACK));
+    b.putPiece(Piece(NIL, WHITE), squareAt(5,4,5));
+
+    // Sliders only attack along their own lines
+    b.putPiece(Piece(MACE, WHITE), squareAt(6,6,6));
+    EXPECT_TRUE(b.isSquareAttacked(sq, WHITE));
+    b.putPiece(Piece(WIZARD, WHITE), squareAt(6,6,6));
+    EXPECT_FALSE(b.isSquareAttacked(sq, WHITE));
+
+    // And can be blocked
+    b.putPiece(Piece(CANNON, WHITE), squareAt(6,6,6));
+    EXPECT_TRUE(b.isSquareAttacked(sq, WHITE));
+    b.putPiece(Piece(ROOK, BLACK), squareAt(5,5,5));
+    EXPECT_FALSE(b.isSquareAttacked(sq, WHITE));
+    b.putPiece(Piece(NIL, WHITE), squareAt(5,5,5));
+    b.putPiece(Piece(NIL, WHITE), squareAt(6,6,6));
+
+    // Kings only attack adjacent squares
+    b.putPiece(Piece(KING, BLACK), squareAt(4,2,4));
+    EXPECT_TRUE(b.isSquareAttacked(sq, BLACK));
+    b.putPiece(Piece(NIL, WHITE), squareAt(4,2,4));
+    b.putPiece(Piece(KING, BLACK), squareAt(5,3,3));
+    EXPECT_FALSE(b.isSquareAttacked(sq, BLACK));
+}
+
+/**
+ * Returns true if the move doesn't leave the mover in check, by actually
+ * making it. Castling is left to isLegalMove, since it also cares about the
+ * squares the king passes through.
+ */
+bool bruteForceLegal(const Board& b, const Move& m)
+{
+    if(m.type() == CASTLE)
+        return b.isLegalMove(m);
+
+    Board copy (b);
+    copy.makeMove(m);
+    return !copy.isInCheck(m.color());
+}
+
+/**
+ * Returns true if generateLegalMoves, isLegalMove and hasLegalMove agree with
+ * filtering the pseudo-legal moves by brute force.
+ */
+bool legalMovesMatch(const Board& b, bool color)
+{
+    MoveList pseudo, legal;
+    b.generatePseudoLegalMoves(color, pseudo);
+    b.generateLegalMoves(color, legal);
+
+    int num_legal = 0;
+    for(const Move* it = pseudo.begin(); it != pseudo.end(); it++)
+    {
+        if(b.isLegalMove(*it) != bruteForceLegal(b, *it))
+            return false;
+
+        if(b.isLegalMove(*it))
+        {
+            num_legal++;
+            if(!legal.contains(*it))
+                return false;
+        }
+    }
+
+    if(b.hasLegalMove(color) != (num_legal > 0))
+        return false;
+
+    return num_legal == legal.size();
+}
+
+TEST(MoveLegality, LegalGeneration)
+{
+    // Kings surrounded by a handful of random pieces give plenty of pins and
+    // checks, including double checks
+    PieceType types [] = {
+        W_PAWN, KNIGHT, GRIFFIN, DRAGON, UNICORN, ROOK, BISHOP, MACE,
+        WIZARD, ARCHER, CANNON, QUEEN
+    };
+
+    unsigned int seed = 2718;
+    for(int trial = 0; trial < 300; trial++)
+    {
+        Board b;
+        b.putPiece(Piece(KING, WHITE), squareAt(3,4,2));
+        b.putPiece(Piece(KING, BLACK), squareAt(5,1,6));
+
+        for(int n = 0; n < 12; n++)
+        {
+            seed = seed * 1103515245 + 12345;
+            int sq = squareAt((seed >> 8) & 7, (seed >> 11) & 7, (seed >> 14) & 7);
+            PieceType pt = types[(seed >> 17) % 12];
+            bool color = (seed >> 24) & 1;
+            if(pt == W_PAWN)
+                pt = (color == WHITE) ? W_PAWN : B_PAWN;
+
+            if(b.getPiece(sq).type() == NIL)
+                b.putPiece(Piece(pt, color), sq);
+        }
+
+        ASSERT_TRUE(legalMovesMatch(b, WHITE));
+        ASSERT_TRUE(legalMovesMatch(b, BLACK));
+    }
+
+    // And from the initial position
+    Board b;
+    b.setup();
+    EXPECT_TRUE(legalMovesMatch(b, WHITE));
+    EXPECT_TRUE(legalMovesMatch(b, BLACK));
+}
+
+TEST(MoveLegality, GameState)
+{
+    // The white king is boxed in by its own pawns, and a knight checks it
+    Board b;
+    b.putPiece(Piece(KING, WHITE), squareAt(0,0,0));
+    b.putPiece(Piece(KING, BLACK), squareAt(7,7,7));
+    b.putPiece(Piece(W_PAWN, WHITE), squareAt(1,0,0));
+    b.putPiece(Piece(W_PAWN, WHITE), squareAt(0,1,0));
+    b.putPiece(Piece(W_PAWN, WHITE), squareAt(1,1,0));
+    b.putPiece(Piece(W_PAWN, WHITE), squareAt(0,0,1));
+    b.putPiece(Piece(W_PAWN, WHITE), squareAt(1,0,1));
+    b.putPiece(Piece(W_PAWN, WHITE), squareAt(0,1,1));
+    b.putPiece(Piece(W_PAWN, WHITE), squareAt(1,1,1));
+
+    EXPECT_TRUE(b.hasLegalMove(WHITE));
+    EXPECT_TRUE(b.getGameState() == IN_PROGRESS);
+
+    Piece bn (KNIGHT, BLACK);
+    b.putPiece(bn, squareAt(2,1,0));
+    EXPECT_FALSE(b.hasLegalMove(WHITE));
+    EXPECT_TRUE(b.getGameState() == CHECKMATE_WHITE);
+
+    // Now play into it: White makes a move elsewhere, and the knight jumps in
+    b.putPiece(Piece(NIL, WHITE), squareAt(2,1,0));
+    b.putPiece(bn, squareAt(3,1,2));
+    b.putPiece(Piece(ROOK, WHITE), squareAt(7,0,3));
+    b.makeMove(Move(WHITE, QUIET, squareAt(7,0,3), squareAt(7,0,4)));
+    EXPECT_TRUE(b.whoseTurn() == BLACK);
+    EXPECT_TRUE(b.getGameState() == IN_PROGRESS);
+
+    b.makeMove(Move(BLACK, QUIET, squareAt(3,1,2), squareAt(2,1,0)));
+    EXPECT_TRUE(b.getGameState() == CHECKMATE_WHITE);
+
+    // Each ply remembers its own state
+    b.undoMove();
+    EXPECT_TRUE(b.getGameState() == IN_PROGRESS);
+}
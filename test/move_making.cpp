@@ -8,8 +8,8 @@ TEST(MoveMaking, Quiet)
 {
     // The rook will move from i to j
     Piece wr (ROOK, WHITE);
-    int i = mailbox(6,3,5);
-    int j = mailbox(6,6,5);
+    int i = squareAt(6,3,5);
+    int j = squareAt(6,6,5);
     Move m = Move(WHITE, QUIET, i, j);
 
     Board b;
@@ -32,8 +32,8 @@ TEST(MoveMaking, DPP)
 {
     // The pawn will move from i to j
     Piece wp (W_PAWN, WHITE);
-    int i = mailbox(3,5,1);
-    int j = mailbox(3,5,3);
+    int i = squareAt(3,5,1);
+    int j = squareAt(3,5,3);
     Move m = Move(WHITE, DOUBLE_PAWN_PUSH, i, j);
 
     // Put the pieces down
@@ -58,8 +58,8 @@ TEST(MoveMaking, Capture)
     // The rook will capture the knight
     Piece wr (ROOK, WHITE);
     Piece bn (KNIGHT, BLACK);
-    int i = mailbox(6,3,5);
-    int j = mailbox(6,6,5);
+    int i = squareAt(6,3,5);
+    int j = squareAt(6,6,5);
     Move m = Move(WHITE, CAPTURE, i, j);
 
     // Put the pieces down
@@ -94,10 +94,10 @@ TEST(MoveMaking, EnPassant)
      * +-------+
      *   1 2 3
      */
-    int i = mailbox(2,5,4);
-    int j = mailbox(3,5,6);
-    int k = mailbox(3,5,5);
-    int l = mailbox(3,5,4);
+    int i = squareAt(2,5,4);
+    int j = squareAt(3,5,6);
+    int k = squareAt(3,5,5);
+    int l = squareAt(3,5,4);
 
     Move first = Move(BLACK, DOUBLE_PAWN_PUSH, j, l);
     Move second = Move(WHITE, EN_PASSANT, i, k);
@@ -138,10 +138,10 @@ TEST(MoveMaking, CastleKingside)
     Piece wk (KING, WHITE);
     Piece wr (ROOK, WHITE);
 
-    int i = mailbox(4,4,0);
-    int j = mailbox(4,5,0);
-    int k = mailbox(4,6,0);
-    int l = mailbox(4,7,0);
+    int i = squareAt(4,4,0);
+    int j = squareAt(4,5,0);
+    int k = squareAt(4,6,0);
+    int l = squareAt(4,7,0);
 
     Board b;
     b.putPiece(wk, i);
@@ -169,10 +169,10 @@ TEST(MoveMaking, CastleQueenside)
     Piece bk (KING, BLACK);
     Piece br (ROOK, BLACK);
 
-    int i = mailbox(4,4,7);
-    int j = mailbox(3,3,7);
-    int k = mailbox(2,2,7);
-    int l = mailbox(0,0,7);
+    int i = squareAt(4,4,7);
+    int j = squareAt(3,3,7);
+    int k = squareAt(2,2,7);
+    int l = squareAt(0,0,7);
 
     Board b;
     b.putPiece(bk, i);
@@ -200,8 +200,8 @@ TEST(MoveMaking, Promotion)
     // The pawn should move from i to j and promote to the queen.
     Piece wp (W_PAWN, WHITE);
     Piece wq (QUEEN, WHITE);
-    int i = mailbox(5,1,6);
-    int j = mailbox(5,1,7);
+    int i = squareAt(5,1,6);
+    int j = squareAt(5,1,7);
     Move m = Move(WHITE, PROMOTE, i, j, QUEEN);
 
     Board b;
@@ -227,8 +227,8 @@ TEST(MoveMaking, PromoCapture)
     Piece wp (W_PAWN, WHITE);
     Piece wq (QUEEN, WHITE);
     Piece bn (KNIGHT, BLACK);
-    int i = mailbox(5,1,6);
-    int j = mailbox(5,2,7);
+    int i = squareAt(5,1,6);
+    int j = squareAt(5,2,7);
     Move m = Move(WHITE, PROMO_CAPTURE, i, j, QUEEN);
 
     Board b;
@@ -247,3 +247,185 @@ TEST(MoveMaking, PromoCapture)
     EXPECT_TRUE(b.getPiece(i) == wp);
     EXPECT_TRUE(b.getPiece(j) == bn);
 }
+
+/**
+ * Returns true if the board's piece lists agree with the pieces actually on
+ * the board.
+ */
+bool pieceListsMatch(const Board& b)
+{
+    for(int color = 0; color < 2; color++)
+    {
+        int count = 0;
+        int type_counts [16] = {};
+
+        for(int i = 0; i < 8; i++)
+        {
+            for(int j = 0; j < 8; j++)
+            {
+                for(int k = 0; k < 8; k++)
+                {
+                    Piece p = b.getPiece(squareAt(i, j, k));
+                    if(p.isOn(color))
+                    {
+                        count++;
+                        type_counts[p.type()]++;
+                    }
+                }
+            }
+        }
+
+        if(count != b.countPieces(color))
+            return false;
+
+        for(int pt = 0; pt < 16; pt++)
+            if(type_counts[pt] != b.countPieces(color, (PieceType) pt))
+                return false;
+
+        for(int n = 0; n < count; n++)
+            if(!b.getPiece(b.getPieceSquare(color, n)).isOn(color))
+                return false;
+
+        // The occupancy sets have to agree with the squares
+        Bitboard occupied = b.occupied();
+        for(int sq = 0; sq < NUM_SQUARES; sq++)
+        {
+            Piece p = b.getPiece(sq);
+            if(b.pieces(color).test(sq) != p.isOn(color))
+                return false;
+            if(b.pieces(color, p.type()).test(sq) != p.isOn(color))
+                return false;
+            if(occupied.test(sq) != (p.type() != NIL))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+TEST(MoveMaking, PieceLists)
+{
+    Board b;
+    b.setup();
+    EXPECT_TRUE(pieceListsMatch(b));
+    EXPECT_EQ(b.countPieces(WHITE), 128);
+    EXPECT_EQ(b.countPieces(BLACK, B_PAWN), 64);
+
+    // Play out a deterministic, but arbitrary, sequence of moves, preferring
+    // captures so that the lists actually shrink
+    bool color = WHITE;
+    unsigned int seed = 12345;
+    int num_moves = 0;
+    for(; num_moves < 60; num_moves++)
+    {
+        MoveList moves;
+        b.generatePseudoLegalMoves(color, moves);
+        if(moves.empty())
+            break;
+
+        seed = seed * 1103515245 + 12345;
+        Move m = moves[(seed >> 8) % moves.size()];
+        for(const Move* it = moves.begin(); it != moves.end(); it++)
+            if(it->type() == CAPTURE && b.getPiece(it->target()).type() != KING)
+                m = *it;
+
+        b.makeMove(m);
+        ASSERT_TRUE(pieceListsMatch(b));
+        color = !color;
+    }
+
+    EXPECT_LT(b.countPieces(WHITE) + b.countPieces(BLACK), 256);
+
+    // And unwind it all again
+    for(; num_moves > 0; num_moves--)
+    {
+        b.undoMove();
+        ASSERT_TRUE(pieceListsMatch(b));
+    }
+
+    EXPECT_EQ(b.countPieces(WHITE), 128);
+    EXPECT_EQ(b.countPieces(BLACK), 128);
+
+    // A side that has as many pieces as the lists hold can't get another
+    Piece queen (QUEEN, WHITE);
+    EXPECT_TRUE(b.putPiece(queen, squareAt(3,3,3)) == queen);
+    EXPECT_EQ(b.getPiece(squareAt(3,3,3)).type(), NIL);
+    EXPECT_TRUE(b.putPiece(queen, squareAt(3,3,7)) == queen);
+    EXPECT_TRUE(b.getPiece(squareAt(3,3,7)).isOn(BLACK));
+    EXPECT_EQ(b.countPieces(WHITE), 128);
+
+    // But it can swap one of its pieces for another
+    b.putPiece(queen, squareAt(3,3,1));
+    EXPECT_TRUE(b.getPiece(squareAt(3,3,1)) == queen);
+    EXPECT_EQ(b.countPieces(WHITE), 128);
+    EXPECT_TRUE(pieceListsMatch(b));
+}
+
+TEST(MoveMaking, Hash)
+{
+    Board b;
+    b.setup();
+
+    // Knights out and back again reach the same position, with the same side
+    // to move
+    Move w_out (WHITE, QUIET, squareAt(3,1,0), squareAt(3,3,1));
+    Move b_out (BLACK, QUIET, squareAt(3,1,7), squareAt(3,3,6));
+    Move w_in (WHITE, QUIET, squareAt(3,3,1), squareAt(3,1,0));
+    Move b_in (BLACK, QUIET, squareAt(3,3,6), squareAt(3,1,7));
+
+    // The pawns are in the way, so take them off first
+    b.putPiece(Piece(NIL, WHITE), squareAt(3,3,1));
+    b.putPiece(Piece(NIL, WHITE), squareAt(3,3,6));
+    uint64_t start = b.hash();
+
+    b.makeMove(w_out);
+    EXPECT_NE(b.hash(), start);
+    uint64_t after_one = b.hash();
+    b.makeMove(b_out);
+    b.makeMove(w_in);
+    b.makeMove(b_in);
+    EXPECT_EQ(b.hash(), start);
+
+    // The same pieces, but with the other side to move, hash differently
+    b.makeMove(w_out);
+    EXPECT_EQ(b.hash(), after_one);
+    b.undoMove();
+
+    // Undoing restores every hash along the way
+    b.undoMove();
+    b.undoMove();
+    b.undoMove();
+    EXPECT_EQ(b.hash(), after_one);
+    b.undoMove();
+    EXPECT_EQ(b.hash(), start);
+
+    // Double pawn pushes set an en passant square, which is part of the hash
+    Board c, d;
+    c.putPiece(Piece(W_PAWN, WHITE), squareAt(2,2,1));
+    d.putPiece(Piece(W_PAWN, WHITE), squareAt(2,2,2));
+    c.makeMove(Move(WHITE, DOUBLE_PAWN_PUSH, squareAt(2,2,1), squareAt(2,2,3)));
+    d.makeMove(Move(WHITE, QUIET, squareAt(2,2,2), squareAt(2,2,3)));
+    EXPECT_NE(c.hash(), d.hash());
+}
+
+TEST(MoveMaking, NullMove)
+{
+    Board b;
+    b.setup();
+    b.makeMove(Move(WHITE, DOUBLE_PAWN_PUSH, squareAt(2,2,1), squareAt(2,2,3)));
+    uint64_t hash = b.hash();
+
+    // Passing the turn changes the side to move, and the en passant square
+    // goes away
+    b.makeNullMove();
+    EXPECT_EQ(b.whoseTurn(), WHITE);
+    EXPECT_NE(b.hash(), hash);
+
+    Board passed;
+    passed.setPosition(b.getPosition());
+    EXPECT_EQ(passed.hash(), b.hash());
+
+    b.undoNullMove();
+    EXPECT_EQ(b.whoseTurn(), BLACK);
+    EXPECT_EQ(b.hash(), hash);
+}
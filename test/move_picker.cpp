@@ -0,0 +1,239 @@
+#include "../src/board.h"
+#include "../src/move-picker.h"
+
+#include "unit_test.h"
+
+#include <algorithm>
+#include <vector>
+
+using std::vector;
+
+/** Returns the moves in a list, in some fixed order. */
+static vector<unsigned int> sorted(const vector<Move>& moves)
+{
+    vector<unsigned int> keys;
+    for(size_t i = 0; i < moves.size(); i++)
+        keys.push_back((moves[i].origin() << 16) | (moves[i].target() << 4) |
+                moves[i].promoted());
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+/** Returns everything the picker hands out, in order. */
+static vector<Move> pickAll(MovePicker& picker)
+{
+    vector<Move> moves;
+    for(Move m = picker.next(); m != Move(); m = picker.next())
+        moves.push_back(m);
+    return moves;
+}
+
+/**
+ * Plays a few moves from the setup, picking them so that there are captures
+ * (and pieces out of position) by the end.
+ */
+static void playMoves(Board& b, int plies)
+{
+    for(int n = 0; n < plies; n++)
+    {
+        MoveList moves;
+        b.generateLegalMoves(b.whoseTurn(), moves);
+
+        // Take something if we can
+        Move m = moves[(n * 7919) % moves.size()];
+        for(const Move* it = moves.begin(); it != moves.end(); it++)
+            if(it->type() == CAPTURE && n % 3 == 0)
+                m = *it;
+
+        b.makeMove(m);
+    }
+}
+
+/**
+ * A board where pawns can promote, with and without capturing, and other
+ * pieces have captures of their own.
+ */
+static Board promotionBoard()
+{
+    Board b;
+    b.putPiece(Piece(KING, WHITE), squareAt(0,0,0));
+    b.putPiece(Piece(KING, BLACK), squareAt(7,7,7));
+    b.putPiece(Piece::Pawn(WHITE), squareAt(3,3,6));
+    b.putPiece(Piece(ROOK, BLACK), squareAt(4,3,7));
+    b.putPiece(Piece(QUEEN, WHITE), squareAt(4,3,3));
+    b.putPiece(Piece::Pawn(BLACK), squareAt(4,3,1));
+    b.putPiece(Piece(KNIGHT, WHITE), squareAt(4,1,2));
+    return b;
+}
+
+TEST(MovePicker, GeneratorsSplit)
+{
+    vector<Board> boards (3);
+    boards[0].setup();
+    boards[1].setup();
+    playMoves(boards[1], 30);
+    boards[2] = promotionBoard();
+
+    for(size_t i = 0; i < boards.size(); i++)
+    {
+        const Board& b = boards[i];
+        bool color = b.whoseTurn();
+
+        MoveList all, captures, promotions, quiets;
+        b.generatePseudoLegalMoves(color, all);
+        b.generateCaptures(color, captures);
+        b.generatePromotions(color, promotions);
+        b.generateQuiets(color, quiets);
+
+        vector<Move> split (captures.begin(), captures.end());
+        split.insert(split.end(), promotions.begin(), promotions.end());
+        split.insert(split.end(), quiets.begin(), quiets.end());
+
+        vector<Move> expected (all.begin(), all.end());
+        EXPECT_TRUE(sorted(split) == sorted(expected));
+
+        for(const Move* it = captures.begin(); it != captures.end(); it++)
+        {
+            MoveType type = it->type();
+            EXPECT_TRUE(type == CAPTURE || type == EN_PASSANT ||
+                        type == PROMO_CAPTURE);
+        }
+
+        for(const Move* it = promotions.begin(); it != promotions.end(); it++)
+            EXPECT_EQ(it->type(), PROMOTE);
+    }
+
+    // The last board has all three kinds
+    EXPECT_FALSE(boards[2].isInCheck(WHITE));
+    MoveList promotions;
+    boards[2].generatePromotions(WHITE, promotions);
+    EXPECT_EQ(promotions.size(), NUM_PROMOTION_PIECES);
+}
+
+TEST(MovePicker, PseudoLegality)
+{
+    Board b;
+    b.setup();
+
+    // A move the setup allows, and some that it doesn't
+    Move push (WHITE, DOUBLE_PAWN_PUSH, squareAt(2,2,1), squareAt(2,2,3));
+    Move blocked (WHITE, QUIET, squareAt(3,3,0), squareAt(3,3,2));
+    Move empty (WHITE, QUIET, squareAt(3,3,3), squareAt(3,3,4));
+    Move wrong_color (BLACK, QUIET, squareAt(2,2,1), squareAt(2,2,2));
+
+    EXPECT_TRUE(b.isPseudoLegalMove(push));
+    EXPECT_FALSE(b.isPseudoLegalMove(blocked));
+    EXPECT_FALSE(b.isPseudoLegalMove(empty));
+    EXPECT_FALSE(b.isPseudoLegalMove(wrong_color));
+
+    // Once the pawn has moved, the same push isn't possible again
+    b.makeMove(push);
+    EXPECT_FALSE(b.isPseudoLegalMove(push));
+}
+
+TEST(MovePicker, PicksEveryMoveOnce)
+{
+    Board b;
+    b.setup();
+    playMoves(b, 30);
+
+    MoveList all;
+    b.generatePseudoLegalMoves(b.whoseTurn(), all);
+    vector<Move> expected (all.begin(), all.end());
+
+    // Without any help
+    MovePicker plain (b, Move(), NULL);
+    EXPECT_TRUE(sorted(pickAll(plain)) == sorted(expected));
+
+    // With a hash move and killers, which shouldn't be repeated, and a killer
+    // that isn't possible here
+    Move hash_move = all[all.size() / 2];
+    Move killers [NUM_KILLERS] = { all[all.size() - 1], Move(WHITE, QUIET,
+            squareAt(0,0,3), squareAt(0,0,4)) };
+
+    MovePicker picker (b, hash_move, killers);
+    vector<Move> picked = pickAll(picker);
+    EXPECT_TRUE(sorted(picked) == sorted(expected));
+    EXPECT_TRUE(picked[0] == hash_move);
+}
+
+TEST(MovePicker, Order)
+{
+    Board b = promotionBoard();
+    Move killer (WHITE, QUIET, squareAt(0,0,0), squareAt(1,0,0));
+    Move killers [NUM_KILLERS] = { killer, killer };
+
+    MovePicker picker (b, Move(), killers);
+    vector<Move> picked = pickAll(picker);
+
+    // The pawn takes the rook first, best promotion first, and then the queen
+    // takes it. Then the knight takes the pawn.
+    ASSERT_TRUE(picked.size() > 2 * NUM_PROMOTION_PIECES + 3);
+    EXPECT_EQ(picked[0].type(), PROMO_CAPTURE);
+    EXPECT_EQ(picked[0].promoted(), QUEEN);
+
+    size_t n = NUM_PROMOTION_PIECES;
+    EXPECT_EQ(picked[n].origin(), squareAt(4,3,3));
+    EXPECT_EQ(picked[n].target(), squareAt(4,3,7));
+    EXPECT_EQ(picked[n + 1].origin(), squareAt(4,1,2));
+
+    // Then the promotions, best first, and then the killer, just once
+    n += 2;
+    EXPECT_EQ(picked[n].type(), PROMOTE);
+    EXPECT_EQ(picked[n].promoted(), QUEEN);
+
+    n += NUM_PROMOTION_PIECES;
+    EXPECT_TRUE(picked[n] == killer);
+    EXPECT_EQ(std::count(picked.begin(), picked.end(), killer), 1);
+
+    // Everything after is quiet, except for the queen taking the pawn. The
+    // rook behind the queen would take back, so that one comes last.
+    for(size_t i = n; i < picked.size() - 1; i++)
+        EXPECT_EQ(picked[i].type(), QUIET);
+    EXPECT_EQ(picked.back().origin(), squareAt(4,3,3));
+    EXPECT_EQ(picked.back().target(), squareAt(4,3,1));
+}
+
+TEST(MovePicker, CapturesOnly)
+{
+    Board b = promotionBoard();
+
+    MoveList captures;
+    b.generateCaptures(WHITE, captures);
+    vector<Move> expected;
+    for(const Move* it = captures.begin(); it != captures.end(); it++)
+        if(b.staticExchange(*it) >= 0)
+            expected.push_back(*it);
+
+    // The queen taking the pawn loses it to the rook, so it's left out
+    EXPECT_EQ((int) expected.size(), captures.size() - 1);
+
+    // A quiet hash move isn't used
+    Move quiet (WHITE, QUIET, squareAt(0,0,0), squareAt(1,0,0));
+    MovePicker picker (b, quiet);
+    EXPECT_TRUE(sorted(pickAll(picker)) == sorted(expected));
+}
+
+TEST(MovePicker, HistoryOrder)
+{
+    Board b = promotionBoard();
+    Move good (WHITE, QUIET, squareAt(4,1,2), squareAt(5,3,2));
+    Move bad (WHITE, QUIET, squareAt(0,0,0), squareAt(1,0,0));
+
+    History history;
+    history.update(good, 100);
+    history.update(bad, -100);
+
+    MovePicker picker (b, Move(), NULL, &history);
+    vector<Move> picked = pickAll(picker);
+
+    // The quiet moves come next to last, from the best score to the worst
+    size_t n = std::find(picked.begin(), picked.end(), good) - picked.begin();
+    size_t last = picked.size() - 2;
+    ASSERT_TRUE(n < last);
+    EXPECT_TRUE(picked[last] == bad);
+    for(size_t i = n; i <= last; i++)
+        EXPECT_EQ(picked[i].type(), QUIET);
+    for(size_t i = 0; i < n; i++)
+        EXPECT_NE(picked[i].type(), QUIET);
+}
@@ -0,0 +1,213 @@
+#include "../src/board.h"
+#include "../src/evaluate.h"
+#include "../src/history.h"
+#include "../src/nnue.h"
+#include "../src/search.h"
+#include "../src/transposition-table.h"
+
+#include "unit_test.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/** Fills the network with small pseudo-random weights. */
+static void randomize(Network& net)
+{
+    uint32_t seed = 12345;
+    for(size_t i = 0; i < net.feature_weights.size(); i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        net.feature_weights[i] = (int16_t) ((seed >> 16) % 33) - 16;
+    }
+    for(int i = 0; i < NNUE_HIDDEN; i++)
+        net.feature_biases[i] = (int16_t) (i % 64);
+    for(int i = 0; i < 2 * NNUE_HIDDEN; i++)
+        net.output_weights[i] = (int8_t) ((i * 37) % 129 - 64);
+    net.output_bias = 1000;
+}
+
+/** Returns true if the two boards have the same accumulator. */
+static bool sameAccumulator(const Board& a, const Board& b)
+{
+    const Accumulator& x = a.accumulator();
+    const Accumulator& y = b.accumulator();
+    return memcmp(x.values, y.values, sizeof(x.values)) == 0;
+}
+
+TEST(Nnue, Features)
+{
+    // Black sees the board flipped, with its own pieces as White sees its own
+    Piece wn (KNIGHT, WHITE);
+    Piece bn (KNIGHT, BLACK);
+    int sq = squareAt(2,5,1);
+    int flipped = squareAt(2,5,6);
+    int wk = squareAt(4,0,0);
+    int bk = squareAt(4,0,7);
+    EXPECT_EQ(Network::feature(WHITE, wn, sq, wk),
+              Network::feature(BLACK, bn, flipped, bk));
+    EXPECT_EQ(Network::feature(WHITE, bn, sq, wk),
+              Network::feature(BLACK, wn, flipped, bk));
+    EXPECT_NE(Network::feature(WHITE, wn, sq, wk),
+              Network::feature(WHITE, bn, sq, wk));
+
+    // Both pawns are the same kind, and every feature is in range
+    EXPECT_EQ(Network::feature(WHITE, Piece(W_PAWN, WHITE), sq, wk),
+              Network::feature(WHITE, Piece(B_PAWN, WHITE), sq, wk));
+    EXPECT_EQ(Network::kingBucket(WHITE, wk), 1);
+    EXPECT_EQ(Network::kingBucket(BLACK, bk), 1);
+    EXPECT_EQ(Network::kingBucket(WHITE, squareAt(7,7,7)), 7);
+    EXPECT_LT(Network::feature(BLACK, Piece(KING, WHITE), squareAt(7,7,0),
+                               squareAt(0,0,0)), NNUE_FEATURES);
+}
+
+TEST(Nnue, SaveLoad)
+{
+    Network net;
+    randomize(net);
+
+    const char* path = "log/nnue_test.bin";
+    ASSERT_TRUE(net.save(path));
+
+    Network loaded;
+    ASSERT_TRUE(loaded.load(path));
+    EXPECT_TRUE(loaded.feature_weights == net.feature_weights);
+    EXPECT_EQ(memcmp(loaded.feature_biases, net.feature_biases,
+                     sizeof(net.feature_biases)), 0);
+    EXPECT_EQ(memcmp(loaded.output_weights, net.output_weights,
+                     sizeof(net.output_weights)), 0);
+    EXPECT_EQ(loaded.output_bias, net.output_bias);
+
+    // A file with anything more or less is turned down, and changes nothing
+    ASSERT_TRUE(Network().save(path));
+    FILE* f = fopen(path, "ab");
+    ASSERT_TRUE(f != NULL);
+    fputc(0, f);
+    fclose(f);
+    EXPECT_FALSE(loaded.load(path));
+    EXPECT_EQ(loaded.output_bias, net.output_bias);
+    EXPECT_FALSE(loadNetwork("log/no_such_network.bin"));
+    EXPECT_TRUE(activeNetwork() == NULL);
+
+    remove(path);
+}
+
+TEST(Nnue, Incremental)
+{
+    Network net;
+    randomize(net);
+    setActiveNetwork(&net);
+
+    // A few pieces, so that the kings get to move between buckets
+    Board b;
+    b.putPiece(Piece(KING, WHITE), squareAt(3,3,3));
+    b.putPiece(Piece(KING, BLACK), squareAt(4,4,4));
+    b.putPiece(Piece(QUEEN, WHITE), squareAt(0,0,0));
+    b.putPiece(Piece(ROOK, BLACK), squareAt(7,7,7));
+    b.putPiece(Piece::Pawn(WHITE), squareAt(2,5,5));
+    b.putPiece(Piece::Pawn(BLACK), squareAt(5,2,2));
+    b.putPiece(Piece(KNIGHT, BLACK), squareAt(6,1,3));
+
+    Board start = b;
+    b.accumulator();
+    for(int n = 0; n < 100; n++)
+    {
+        MoveList moves;
+        b.generateLegalMoves(b.whoseTurn(), moves);
+        if(moves.empty())
+            break;
+
+        b.makeMove(moves[(n * 7919) % moves.size()]);
+
+        Board fresh;
+        fresh.setPosition(b.getPosition());
+        ASSERT_TRUE(sameAccumulator(b, fresh));
+        ASSERT_EQ(evaluate(b), evaluate(fresh));
+    }
+
+    // Undoing gets back to the same values, one way or the other
+    int plies = b.getHistory().size();
+    for(int n = 0; n < plies; n++)
+        b.undoMove();
+    EXPECT_TRUE(sameAccumulator(b, start));
+
+    // And the setup scores the same for either side, since each sees it the
+    // same way
+    b.setup();
+    int white = evaluate(b);
+    b.makeNullMove();
+    EXPECT_EQ(evaluate(b), white);
+    b.undoNullMove();
+
+    // Without a network, it's the handcrafted evaluation again
+    setActiveNetwork(NULL);
+    EXPECT_EQ(evaluate(b), 0);
+}
+
+TEST(Nnue, Simd)
+{
+    Network net;
+    randomize(net);
+    setActiveNetwork(&net);
+
+    Board b;
+    b.setup();
+    MoveList moves;
+    b.generateLegalMoves(WHITE, moves);
+    b.makeMove(moves[moves.size() / 2]);
+
+    // The scalar kernels give exactly what the AVX2 ones do, if there are any
+    bool simd = setSimd(true);
+    Board fresh;
+    fresh.setPosition(b.getPosition());
+    int with = evaluate(fresh);
+
+    setSimd(false);
+    Board scalar;
+    scalar.setPosition(b.getPosition());
+    EXPECT_EQ(evaluate(scalar), with);
+    EXPECT_TRUE(sameAccumulator(scalar, fresh));
+
+    setSimd(simd);
+    setActiveNetwork(NULL);
+}
+
+TEST(Nnue, Saturated)
+{
+    // Every hidden value is clipped at the top, and every output weight is as
+    // large as it gets, so the network says far more than a mate
+    Network net;
+    for(int i = 0; i < NNUE_HIDDEN; i++)
+        net.feature_biases[i] = NNUE_QA;
+    for(int i = 0; i < 2 * NNUE_HIDDEN; i++)
+        net.output_weights[i] = 127;
+    net.output_bias = 2000000000;
+    setActiveNetwork(&net);
+
+    Board b;
+    b.setup();
+    EXPECT_EQ(evaluate(b), NNUE_MAX_SCORE);
+
+    bool simd = setSimd(false);
+    Board scalar;
+    scalar.setup();
+    EXPECT_EQ(evaluate(scalar), NNUE_MAX_SCORE);
+    setSimd(simd);
+
+    for(int i = 0; i < 2 * NNUE_HIDDEN; i++)
+        net.output_weights[i] = -128;
+    net.output_bias = -2000000000;
+    EXPECT_EQ(evaluate(b), -NNUE_MAX_SCORE);
+
+    // The search doesn't take that for a mate, and goes on deepening
+    SearchLimits limits;
+    limits.depth = 2;
+    TranspositionTable table (1);
+    History history;
+    Search search (b, table, history);
+    SearchResult result = search.run(limits);
+    EXPECT_EQ(result.depth, 2);
+    EXPECT_LT(std::abs(result.score), MATE_BOUND);
+
+    setActiveNetwork(NULL);
+}
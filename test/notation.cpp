@@ -0,0 +1,79 @@
+#include "../src/board.h"
+#include "../src/notation.h"
+
+#include "unit_test.h"
+
+TEST(Notation, Squares)
+{
+    EXPECT_TRUE(squareName(squareAt(4,4,0)) == "e5A");
+    EXPECT_TRUE(squareName(squareAt(7,0,7)) == "h1H");
+
+    for(int sq = 0; sq < NUM_SQUARES; sq++)
+        ASSERT_EQ(parseSquare(squareName(sq)), sq);
+
+    EXPECT_EQ(parseSquare("i1A"), -1);
+    EXPECT_EQ(parseSquare("a9A"), -1);
+    EXPECT_EQ(parseSquare("a1"), -1);
+}
+
+TEST(Notation, Pieces)
+{
+    for(int pt = W_PAWN; pt <= KING; pt++)
+    {
+        for(int color = 0; color < 2; color++)
+        {
+            Piece p ((PieceType) pt, color);
+            if(pt == W_PAWN || pt == B_PAWN)
+                p = Piece::Pawn(color);
+
+            EXPECT_TRUE(parsePieceLetter(pieceLetter(p)) == p);
+        }
+    }
+
+    EXPECT_TRUE(pieceLetter(Piece(GRIFFIN, BLACK)) == 'g');
+    EXPECT_TRUE(parsePieceLetter('x').type() == NIL);
+
+    Move m (WHITE, PROMOTE, squareAt(4,4,6), squareAt(4,4,7), QUEEN);
+    EXPECT_TRUE(moveName(m) == "e5G-e5H=Q");
+}
+
+TEST(Notation, ParseMove)
+{
+    Board b;
+    b.setup();
+
+    // Every legal move reads back as itself
+    MoveList moves;
+    b.generateLegalMoves(WHITE, moves);
+    for(const Move* it = moves.begin(); it != moves.end(); it++)
+        ASSERT_TRUE(parseMove(b, moveName(*it)) == *it);
+
+    // But not Black's, nor anything else
+    EXPECT_TRUE(parseMove(b, "d4G-d4F") == Move());
+    EXPECT_TRUE(parseMove(b, "nonsense") == Move());
+}
+
+TEST(Notation, Positions)
+{
+    Board b;
+    b.setup();
+
+    // A double pawn push leaves an en passant square, and Black to move
+    b.makeMove(Move(WHITE, DOUBLE_PAWN_PUSH, squareAt(2,3,1), squareAt(2,3,3)));
+    std::string position = b.getPosition();
+
+    Board c;
+    ASSERT_TRUE(c.setPosition(position));
+    EXPECT_TRUE(c.getPosition() == position);
+    EXPECT_TRUE(c.whoseTurn() == BLACK);
+    EXPECT_EQ(c.hash(), b.hash());
+    EXPECT_EQ(c.countPieces(WHITE), 128);
+
+    for(int sq = 0; sq < NUM_SQUARES; sq++)
+        ASSERT_TRUE(c.getPiece(sq) == b.getPiece(sq));
+
+    // Bad positions are rejected, and leave the board alone
+    EXPECT_FALSE(c.setPosition("8/8/8 w - -"));
+    EXPECT_FALSE(c.setPosition(position.substr(0, position.size() - 4)));
+    EXPECT_TRUE(c.getPosition() == position);
+}
@@ -0,0 +1,96 @@
+#include "../src/board.h"
+#include "../src/opening-book.h"
+
+#include "unit_test.h"
+
+#include <cstdio>
+
+/** Builds a book from the setup, where White has played a, a and b. */
+static bool writeBook(const char* path, const Move& a, const Move& b)
+{
+    Board start;
+    start.setup();
+
+    BookBuilder first, second;
+    first.add(start.hash(), a, 1.0);
+    first.add(start.hash(), b, 0.0);
+    second.add(start.hash(), a, 0.5);
+
+    // And once by Black, so that it doesn't make the cut
+    start.makeMove(a);
+    second.add(start.hash(), Move(BLACK, QUIET, squareAt(1,0,7),
+            squareAt(2,2,5)), 1.0);
+
+    first.merge(second);
+    return first.size() == 3 && first.write(path, 1) &&
+           first.write(std::string(path) + ".2", 2);
+}
+
+TEST(OpeningBook, Probe)
+{
+    Board b;
+    b.setup();
+
+    MoveList moves;
+    b.generateLegalMoves(WHITE, moves);
+    Move a = moves[0], c = moves[1];
+
+    const char* path = "log/book_test.bin";
+    ASSERT_TRUE(writeBook(path, a, c));
+
+    OpeningBook book;
+    ASSERT_TRUE(book.open(path));
+    EXPECT_EQ(book.size(), 3);
+
+    // The most played move comes first, and knows how it did
+    const BookEntry* begin;
+    const BookEntry* end;
+    book.probe(b.hash(), &begin, &end);
+    ASSERT_EQ(end - begin, 2);
+    EXPECT_TRUE(Move::fromBits(begin[0].move) == a);
+    EXPECT_EQ(begin[0].weight, 2);
+    EXPECT_EQ(begin[0].learn, 50);
+    EXPECT_EQ(begin[1].learn, -100);
+
+    // The move that always lost is never picked
+    for(uint64_t r = 0; r < 20; r++)
+        EXPECT_TRUE(book.pickMove(b, r * 7919) == a);
+
+    // Positions that aren't in the book have no moves
+    b.makeMove(c);
+    book.probe(b.hash(), &begin, &end);
+    EXPECT_TRUE(begin == end);
+    EXPECT_TRUE(book.pickMove(b, 0) == Move());
+
+    // With a minimum count, only White's first move is left
+    ASSERT_TRUE(book.open(std::string(path) + ".2"));
+    EXPECT_EQ(book.size(), 1);
+
+    remove(path);
+    remove((std::string(path) + ".2").c_str());
+}
+
+TEST(OpeningBook, BadFiles)
+{
+    const char* path = "log/book_test.bin";
+    FILE* f = fopen(path, "wb");
+    ASSERT_TRUE(f != NULL);
+    fprintf(f, "3DBK but not really a book");
+    fclose(f);
+
+    OpeningBook book;
+    EXPECT_FALSE(book.open(path));
+    EXPECT_FALSE(book.open("log/no_such_book.bin"));
+    EXPECT_EQ(book.size(), 0);
+
+    // An empty book is still a book
+    ASSERT_TRUE(BookBuilder().write(path, 1));
+    EXPECT_TRUE(book.open(path));
+    EXPECT_EQ(book.size(), 0);
+
+    Board b;
+    b.setup();
+    EXPECT_TRUE(book.pickMove(b, 0) == Move());
+
+    remove(path);
+}
@@ -0,0 +1,120 @@
+#include "../src/board.h"
+#include "../src/pawn-table.h"
+
+#include "unit_test.h"
+
+TEST(PawnTable, PawnHash)
+{
+    Board b;
+    b.setup();
+    uint64_t start = b.pawnHash();
+
+    // Moving a piece leaves the pawn hash alone, but moving a pawn doesn't
+    b.makeMove(Move(WHITE, QUIET, squareAt(1,3,0), squareAt(2,1,2)));
+    EXPECT_EQ(b.pawnHash(), start);
+    b.makeMove(Move(BLACK, QUIET, squareAt(3,3,6), squareAt(3,3,5)));
+    EXPECT_NE(b.pawnHash(), start);
+
+    Board fresh;
+    fresh.setPosition(b.getPosition());
+    EXPECT_EQ(fresh.pawnHash(), b.pawnHash());
+
+    b.undoMove();
+    EXPECT_EQ(b.pawnHash(), start);
+
+    // Without pawns, there's nothing to hash
+    Board empty;
+    empty.putPiece(Piece(KING, WHITE), squareAt(0,0,0));
+    EXPECT_EQ(empty.pawnHash(), 0);
+}
+
+TEST(PawnTable, Setup)
+{
+    Board b;
+    b.setup();
+
+    PawnEntry entry;
+    evaluatePawns(b, entry);
+    EXPECT_EQ(entry.score.mg, 0);
+    EXPECT_EQ(entry.score.eg, 0);
+    EXPECT_TRUE(entry.passed[WHITE].empty());
+    EXPECT_TRUE(entry.passed[BLACK].empty());
+}
+
+TEST(PawnTable, Structure)
+{
+    Board b;
+    Piece wp = Piece::Pawn(WHITE);
+    Piece bp = Piece::Pawn(BLACK);
+
+    // A lone pawn is passed, and isolated
+    b.putPiece(wp, squareAt(3,3,4));
+    PawnEntry lone;
+    evaluatePawns(b, lone);
+    EXPECT_TRUE(lone.passed[WHITE].test(squareAt(3,3,4)));
+
+    // A black pawn ahead of it on a neighbouring file stops that, and the
+    // other way around too
+    b.putPiece(bp, squareAt(4,4,6));
+    PawnEntry blocked;
+    evaluatePawns(b, blocked);
+    EXPECT_TRUE(blocked.passed[WHITE].empty());
+    EXPECT_TRUE(blocked.passed[BLACK].empty());
+    EXPECT_LT(blocked.score.eg, lone.score.eg);
+
+    // But not one behind it
+    Board c;
+    c.putPiece(wp, squareAt(3,3,4));
+    c.putPiece(bp, squareAt(4,4,3));
+    PawnEntry behind;
+    evaluatePawns(c, behind);
+    EXPECT_TRUE(behind.passed[WHITE].test(squareAt(3,3,4)));
+
+    // A neighbour keeps a pawn from being isolated, and a second pawn on
+    // the same file is doubled
+    Board pair, doubled;
+    pair.putPiece(wp, squareAt(3,3,2));
+    pair.putPiece(wp, squareAt(3,4,2));
+    doubled.putPiece(wp, squareAt(3,3,2));
+    doubled.putPiece(wp, squareAt(3,3,3));
+
+    PawnEntry paired, stacked;
+    evaluatePawns(pair, paired);
+    evaluatePawns(doubled, stacked);
+    EXPECT_GT(paired.score.mg, stacked.score.mg);
+
+    // A pawn whose neighbours have all gone ahead, and can't move up to
+    // them safely, is backward
+    Board back, level;
+    back.putPiece(wp, squareAt(3,3,2));
+    back.putPiece(wp, squareAt(4,3,3));
+    back.putPiece(bp, squareAt(2,3,4));
+    level.putPiece(wp, squareAt(3,3,3));
+    level.putPiece(wp, squareAt(4,3,3));
+    level.putPiece(bp, squareAt(2,3,5));
+
+    PawnEntry backward, supported;
+    evaluatePawns(back, backward);
+    evaluatePawns(level, supported);
+    EXPECT_LT(backward.score.mg, supported.score.mg);
+}
+
+TEST(PawnTable, Probe)
+{
+    Board b;
+    b.setup();
+    b.makeMove(Move(WHITE, DOUBLE_PAWN_PUSH, squareAt(2,2,1), squareAt(2,2,3)));
+
+    PawnEntry expected;
+    evaluatePawns(b, expected);
+
+    PawnTable table;
+    const PawnEntry& first = table.probe(b);
+    EXPECT_EQ(first.key, b.pawnHash());
+    EXPECT_TRUE(first.score == expected.score);
+
+    // The second time, it's already there
+    const PawnEntry& second = table.probe(b);
+    EXPECT_EQ(&second, &first);
+    EXPECT_TRUE(second.score == expected.score);
+}
@@ -0,0 +1,177 @@
+#include "../src/board.h"
+#include "../src/history.h"
+#include "../src/search.h"
+#include "../src/transposition-table.h"
+
+#include "unit_test.h"
+
+#include <atomic>
+
+TEST(Search, MateInOne)
+{
+    // The white king is boxed in by its own pawns, and the black knight can
+    // check it from where no pawn can take it
+    Board b;
+    b.putPiece(Piece(KING, WHITE), squareAt(0,0,0));
+    b.putPiece(Piece(KING, BLACK), squareAt(7,7,7));
+    b.putPiece(Piece(W_PAWN, WHITE), squareAt(1,0,0));
+    b.putPiece(Piece(W_PAWN, WHITE), squareAt(0,1,0));
+    b.putPiece(Piece(W_PAWN, WHITE), squareAt(1,1,0));
+    b.putPiece(Piece(W_PAWN, WHITE), squareAt(0,0,1));
+    b.putPiece(Piece(W_PAWN, WHITE), squareAt(1,0,1));
+    b.putPiece(Piece(W_PAWN, WHITE), squareAt(0,1,1));
+    b.putPiece(Piece(W_PAWN, WHITE), squareAt(1,1,1));
+    b.putPiece(Piece(KNIGHT, BLACK), squareAt(3,1,2));
+    b.putPiece(Piece(ROOK, WHITE), squareAt(7,0,3));
+    b.makeMove(Move(WHITE, QUIET, squareAt(7,0,3), squareAt(7,0,4)));
+
+    SearchLimits limits;
+    limits.depth = 3;
+
+    TranspositionTable table (1);
+    History history;
+    Search search (b, table, history);
+    SearchResult result = search.run(limits);
+
+    Move mate (BLACK, QUIET, squareAt(3,1,2), squareAt(2,1,0));
+    EXPECT_TRUE(result.best_move == mate);
+    EXPECT_EQ(result.score, MATE_SCORE - 1);
+    EXPECT_EQ(result.pv.size(), 1);
+}
+
+TEST(Search, PrincipalVariation)
+{
+    Board b;
+    b.setup();
+
+    SearchLimits limits;
+    limits.depth = 3;
+
+    TranspositionTable table (1);
+    History history;
+    Search search (b, table, history);
+    SearchResult result = search.run(limits);
+    EXPECT_EQ(result.depth, 3);
+    ASSERT_FALSE(result.pv.empty());
+    EXPECT_TRUE(result.pv[0] == result.best_move);
+
+    // The whole line has to be playable
+    for(size_t i = 0; i < result.pv.size(); i++)
+    {
+        MoveList moves;
+        b.generateLegalMoves(b.whoseTurn(), moves);
+        ASSERT_TRUE(moves.contains(result.pv[i]));
+        b.makeMove(result.pv[i]);
+    }
+}
+
+TEST(Search, Limits)
+{
+    Board b;
+    b.setup();
+
+    // Even if the first iteration can't finish, there's a move to play
+    SearchLimits limits;
+    limits.nodes = 1;
+
+    TranspositionTable table (1);
+    History history;
+    Search search (b, table, history);
+    SearchResult result = search.run(limits);
+
+    MoveList moves;
+    b.generateLegalMoves(WHITE, moves);
+    EXPECT_TRUE(moves.contains(result.best_move));
+    EXPECT_LT(result.nodes, 10000);
+
+    // Once the time is up, the search stops
+    limits = SearchLimits();
+    limits.milliseconds = 50;
+    result = search.run(limits);
+    EXPECT_TRUE(moves.contains(result.best_move));
+    EXPECT_LT(result.milliseconds, 1000);
+}
+
+TEST(Search, Quiescence)
+{
+    // Taking the pawn looks good at depth 1, until the quiescence search
+    // sees the rook take the queen back
+    Board b;
+    b.putPiece(Piece(KING, WHITE), squareAt(0,0,0));
+    b.putPiece(Piece(KING, BLACK), squareAt(7,7,7));
+    b.putPiece(Piece(QUEEN, WHITE), squareAt(4,3,3));
+    b.putPiece(Piece::Pawn(BLACK), squareAt(4,3,1));
+    b.putPiece(Piece(ROOK, BLACK), squareAt(4,3,7));
+
+    SearchLimits limits;
+    limits.depth = 1;
+
+    TranspositionTable table (1);
+    History history;
+    Search search (b, table, history);
+    SearchResult result = search.run(limits);
+
+    Move grab (WHITE, CAPTURE, squareAt(4,3,3), squareAt(4,3,1));
+    EXPECT_TRUE(result.best_move != grab);
+    EXPECT_LT(result.score, PIECE_VALUES[QUEEN]);
+}
+
+TEST(Search, Params)
+{
+    SearchParams params;
+    EXPECT_TRUE(params.set("null_reduction", 4));
+    EXPECT_EQ(params.null_reduction, 4);
+    EXPECT_TRUE(params.set("lmr_divisor", 300));
+    EXPECT_EQ(params.lmr_divisor, 300);
+    EXPECT_FALSE(params.set("no_such_thing", 1));
+
+    // Without any pruning, the search still finds its way
+    params.set("null_min_depth", MAX_PLY + 1);
+    params.set("lmr_min_depth", MAX_PLY + 1);
+
+    Board b;
+    b.setup();
+
+    SearchLimits limits;
+    limits.depth = 3;
+
+    TranspositionTable table (1);
+    History history;
+    Search search (b, table, history);
+    search.setParams(params);
+    SearchResult result = search.run(limits);
+    EXPECT_EQ(result.depth, 3);
+
+    MoveList moves;
+    b.generateLegalMoves(WHITE, moves);
+    EXPECT_TRUE(moves.contains(result.best_move));
+}
+
+TEST(Search, Parallel)
+{
+    Board b;
+    b.setup();
+
+    SearchLimits limits;
+    limits.depth = 3;
+
+    // The helpers stop once the main search is done
+    TranspositionTable table (1);
+    std::vector<History> histories (3);
+    std::atomic<bool> stop (false);
+    SearchResult result = parallelSearch(b, table, histories, limits,
+            SearchParams(), stop);
+    EXPECT_TRUE(stop);
+    EXPECT_EQ(result.depth, 3);
+
+    MoveList moves;
+    b.generateLegalMoves(WHITE, moves);
+    EXPECT_TRUE(moves.contains(result.best_move));
+
+    // And with the flag already set, nothing gets searched at all, but there
+    // is still a move
+    result = parallelSearch(b, table, histories, limits,
+            SearchParams(), stop);
+    EXPECT_EQ(result.depth, 0);
+    EXPECT_TRUE(moves.contains(result.best_move));
+}
@@ -0,0 +1,85 @@
+#include "../src/board.h"
+
+#include "unit_test.h"
+
+TEST(StaticExchange, Undefended)
+{
+    Board b;
+    b.putPiece(Piece(ROOK, WHITE), squareAt(3,3,0));
+    b.putPiece(Piece(KNIGHT, BLACK), squareAt(3,3,4));
+
+    Move m (WHITE, CAPTURE, squareAt(3,3,0), squareAt(3,3,4));
+    EXPECT_EQ(b.staticExchange(m), PIECE_VALUES[KNIGHT]);
+
+    // Once it's defended, the rook is lost for the knight
+    b.putPiece(Piece(ROOK, BLACK), squareAt(3,3,7));
+    EXPECT_EQ(b.staticExchange(m), PIECE_VALUES[KNIGHT] - PIECE_VALUES[ROOK]);
+
+    // A quiet move onto an attacked square just loses the piece
+    Move quiet (WHITE, QUIET, squareAt(3,3,0), squareAt(3,3,2));
+    EXPECT_EQ(b.staticExchange(quiet), 0);
+    b.putPiece(Piece(ROOK, WHITE), squareAt(0,0,0));
+    Move attacked (WHITE, QUIET, squareAt(0,0,0), squareAt(0,3,7));
+    EXPECT_EQ(b.staticExchange(attacked), -PIECE_VALUES[ROOK]);
+}
+
+TEST(StaticExchange, XRays)
+{
+    // A second rook behind the first takes back along the rook line
+    Board b;
+    b.putPiece(Piece(ROOK, WHITE), squareAt(3,3,0));
+    b.putPiece(Piece(ROOK, WHITE), squareAt(3,3,1));
+    b.putPiece(Piece(KNIGHT, BLACK), squareAt(3,3,4));
+    b.putPiece(Piece(ROOK, BLACK), squareAt(3,3,7));
+
+    Move m (WHITE, CAPTURE, squareAt(3,3,1), squareAt(3,3,4));
+    EXPECT_EQ(b.staticExchange(m), PIECE_VALUES[KNIGHT]);
+
+    // And a queen behind a mace, along one of the eight mace lines
+    Board c;
+    c.putPiece(Piece(QUEEN, WHITE), squareAt(0,0,0));
+    c.putPiece(Piece(MACE, WHITE), squareAt(1,1,1));
+    c.putPiece(Piece(KNIGHT, BLACK), squareAt(4,4,4));
+    c.putPiece(Piece(MACE, BLACK), squareAt(6,6,6));
+
+    Move n (WHITE, CAPTURE, squareAt(1,1,1), squareAt(4,4,4));
+    EXPECT_EQ(c.staticExchange(n), PIECE_VALUES[KNIGHT]);
+}
+
+TEST(StaticExchange, LeastValuableFirst)
+{
+    // The pawn is defended by a knight, so taking it with the queen first
+    // loses the queen for a knight, but with the knight, it's safe to take
+    Board b;
+    b.putPiece(Piece::Pawn(BLACK), squareAt(3,3,4));
+    b.putPiece(Piece(KNIGHT, BLACK), squareAt(1,2,4));
+    b.putPiece(Piece(QUEEN, WHITE), squareAt(3,3,0));
+    b.putPiece(Piece(KNIGHT, WHITE), squareAt(5,4,4));
+
+    Move queen (WHITE, CAPTURE, squareAt(3,3,0), squareAt(3,3,4));
+    Move knight (WHITE, CAPTURE, squareAt(5,4,4), squareAt(3,3,4));
+    EXPECT_EQ(b.staticExchange(queen), PIECE_VALUES[W_PAWN] -
+            PIECE_VALUES[QUEEN] + PIECE_VALUES[KNIGHT]);
+    EXPECT_EQ(b.staticExchange(knight), PIECE_VALUES[W_PAWN]);
+
+    // Nobody has to take back if it would lose: once a rook defends the
+    // pawn too, white stops after black's knight takes back
+    b.putPiece(Piece(ROOK, BLACK), squareAt(3,3,7));
+    EXPECT_EQ(b.staticExchange(knight),
+            PIECE_VALUES[W_PAWN] - PIECE_VALUES[KNIGHT]);
+}
+
+TEST(StaticExchange, King)
+{
+    // The king takes back, unless that would put it in check
+    Board b;
+    b.putPiece(Piece(ROOK, WHITE), squareAt(3,3,0));
+    b.putPiece(Piece(KNIGHT, BLACK), squareAt(3,3,3));
+    b.putPiece(Piece(KING, BLACK), squareAt(4,4,4));
+
+    Move m (WHITE, CAPTURE, squareAt(3,3,0), squareAt(3,3,3));
+    EXPECT_EQ(b.staticExchange(m), PIECE_VALUES[KNIGHT] - PIECE_VALUES[ROOK]);
+
+    b.putPiece(Piece(KNIGHT, WHITE), squareAt(1,2,3));
+    EXPECT_EQ(b.staticExchange(m), PIECE_VALUES[KNIGHT]);
+}
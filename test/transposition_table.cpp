@@ -0,0 +1,64 @@
+#include "../src/common.h"
+#include "../src/transposition-table.h"
+
+#include "unit_test.h"
+
+TEST(TranspositionTable, StoreAndProbe)
+{
+    TranspositionTable table (1);
+    EXPECT_EQ(table.size(), 1 << 20);
+
+    Move m (BLACK, PROMO_CAPTURE, squareAt(7,7,1), squareAt(6,6,0), QUEEN);
+    uint64_t hash = 0x123456789ABCDEF0ULL;
+
+    TableEntry entry;
+    EXPECT_FALSE(table.probe(hash, &entry));
+
+    table.store(hash, m, -31990, 12, BOUND_LOWER);
+    ASSERT_TRUE(table.probe(hash, &entry));
+    EXPECT_TRUE(entry.move == m);
+    EXPECT_EQ(entry.score, -31990);
+    EXPECT_EQ(entry.depth, 12);
+    EXPECT_EQ(entry.bound, BOUND_LOWER);
+
+    // Storing the position again without a move keeps the old one
+    table.store(hash, Move(), 25, 13, BOUND_EXACT);
+    ASSERT_TRUE(table.probe(hash, &entry));
+    EXPECT_TRUE(entry.move == m);
+    EXPECT_EQ(entry.score, 25);
+    EXPECT_EQ(entry.bound, BOUND_EXACT);
+
+    // A hash that lands in the same bucket isn't mistaken for it
+    EXPECT_FALSE(table.probe(hash ^ (1ULL << 63), &entry));
+
+    table.clear();
+    EXPECT_FALSE(table.probe(hash, &entry));
+}
+
+TEST(TranspositionTable, Replacement)
+{
+    // A table of one bucket, so every hash collides
+    TranspositionTable table (0);
+    TableEntry entry;
+    Move m;
+
+    // The bucket fills up without pushing anything out, and then the
+    // shallowest entry goes first
+    for(int n = 0; n < 4; n++)
+        EXPECT_FALSE(table.store(n, m, 0, 10 + n, BOUND_EXACT));
+    EXPECT_TRUE(table.store(4, m, 0, 5, BOUND_EXACT));
+    EXPECT_FALSE(table.probe(0, &entry));
+    EXPECT_TRUE(table.probe(1, &entry));
+    EXPECT_TRUE(table.probe(4, &entry));
+    EXPECT_EQ(table.occupancy(), 1.0);
+
+    // Entries from an old search go before deeper ones from this one, and
+    // pushing them out doesn't count as a collision
+    table.newSearch();
+    EXPECT_EQ(table.occupancy(), 0.0);
+    EXPECT_FALSE(table.store(5, m, 0, 4, BOUND_EXACT));
+    EXPECT_FALSE(table.store(6, m, 0, 4, BOUND_EXACT));
+    EXPECT_FALSE(table.probe(1, &entry));
+    EXPECT_TRUE(table.probe(3, &entry));
+    EXPECT_EQ(table.occupancy(), 0.5);
+}
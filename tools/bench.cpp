@@ -0,0 +1,336 @@
+#include "../src/board.h"
+#include "../src/evaluate.h"
+#include "../src/nnue.h"
+#include "../src/pawn-table.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+ * Micro-benchmarks for the core Board operations. Each workload runs on each
+ * of a few positions: it's warmed up (which also picks how many times to run
+ * it per sample), then timed over a number of samples. The median and 99th
+ * percentile time per operation are reported, and how many operations one
+ * core does per second, at the median.
+ *
+ * The evaluation is the handcrafted one, unless a network is given with
+ * --net, in which case the evaluate workload measures the network.
+ *
+ * Usage: bench [--csv] [--samples <n>] [--filter <workload>] [--net <file>]
+ */
+
+/** How long one sample should take, at least, in nanoseconds. */
+const double SAMPLE_NS = 2e6;
+
+/** A position, with everything the workloads need prepared ahead of time. */
+struct Fixture
+{
+    const char* name;
+    Board board;
+    bool color;
+    MoveList pseudo;
+    MoveList legal;
+    std::vector<int> origins;
+};
+
+/**
+ * A workload runs once over a fixture and returns how many operations it
+ * did. The board is a copy, so workloads are free to make moves on it, as
+ * long as they put it back.
+ */
+struct Workload
+{
+    const char* name;
+    int (*run)(Fixture& f, Board& b);
+};
+
+/** Results go here, so the compiler can't throw the work away. */
+static volatile int sink;
+
+static int runPseudoLegal(Fixture& f, Board& b)
+{
+    MoveList moves;
+    b.generatePseudoLegalMoves(f.color, moves);
+    sink = moves.size();
+    return 1;
+}
+
+static int runGenerateMoves(Fixture& f, Board& b)
+{
+    for(size_t i = 0; i < f.origins.size(); i++)
+    {
+        MoveList moves;
+        b.generateMoves(f.origins[i], moves);
+        sink = moves.size();
+    }
+    return f.origins.size();
+}
+
+static int runIsInCheck(Fixture& f, Board& b)
+{
+    sink = b.isInCheck(WHITE) + b.isInCheck(BLACK);
+    return 2;
+}
+
+static int runIsLegalMove(Fixture& f, Board& b)
+{
+    int legal = 0;
+    for(const Move* it = f.pseudo.begin(); it != f.pseudo.end(); it++)
+        legal += b.isLegalMove(*it);
+    sink = legal;
+    return f.pseudo.size();
+}
+
+static int runMakeUndo(Fixture& f, Board& b)
+{
+    for(const Move* it = f.legal.begin(); it != f.legal.end(); it++)
+    {
+        b.makeMove(*it);
+        b.undoMove();
+    }
+    sink = b.hash();
+    return f.legal.size();
+}
+
+// getGameState remembers its answer for each ply, so to time the real work,
+// each call comes after a fresh move. The move is undone again afterwards.
+static int runGameState(Fixture& f, Board& b)
+{
+    for(const Move* it = f.legal.begin(); it != f.legal.end(); it++)
+    {
+        b.makeMove(*it);
+        sink = b.getGameState();
+        b.undoMove();
+    }
+    return f.legal.size();
+}
+
+/** The pawn structures seen by the evaluate workload, as in a search. */
+static PawnTable pawns;
+
+// Each evaluation comes after a move, as in a search, so this includes
+// updating the network's accumulator (but not undoing the move).
+static int runEvaluate(Fixture& f, Board& b)
+{
+    int total = 0;
+    for(const Move* it = f.legal.begin(); it != f.legal.end(); it++)
+    {
+        b.makeMove(*it);
+        total += evaluate(b, &pawns);
+        b.undoMove();
+    }
+    sink = total;
+    return f.legal.size();
+}
+
+static const Workload WORKLOADS [] = {
+    {"generatePseudoLegalMoves", runPseudoLegal},
+    {"generateMoves", runGenerateMoves},
+    {"isInCheck", runIsInCheck},
+    {"isLegalMove", runIsLegalMove},
+    {"makeMove/undoMove", runMakeUndo},
+    {"getGameState", runGameState},
+    {"evaluate", runEvaluate}
+};
+
+static const int NUM_WORKLOADS = sizeof(WORKLOADS) / sizeof(WORKLOADS[0]);
+
+/**
+ * Plays a deterministic, but arbitrary, sequence of moves from the setup. The
+ * moves are picked by scrambling their squares, so the order they're
+ * generated in doesn't matter.
+ */
+static void playMoves(Board& b, int plies)
+{
+    unsigned int seed = 12345;
+    for(int n = 0; n < plies; n++)
+    {
+        MoveList moves;
+        b.generateLegalMoves(b.whoseTurn(), moves);
+        if(moves.empty())
+            break;
+
+        seed = seed * 1103515245 + 12345;
+
+        Move best;
+        unsigned int best_key = 0;
+        for(const Move* it = moves.begin(); it != moves.end(); it++)
+        {
+            unsigned int key = (it->origin() << 13) | (it->target() << 4) |
+                               it->promoted();
+            key = (key ^ seed) * 2654435761u;
+            if(key >= best_key)
+            {
+                best = *it;
+                best_key = key;
+            }
+        }
+
+        b.makeMove(best);
+    }
+}
+
+/** Fills in everything a fixture needs, once its board is set up. */
+static void prepare(Fixture& f)
+{
+    f.color = f.board.whoseTurn();
+    f.board.generatePseudoLegalMoves(f.color, f.pseudo);
+    f.board.generateLegalMoves(f.color, f.legal);
+
+    for(int n = 0; n < f.board.countPieces(f.color); n++)
+        f.origins.push_back(f.board.getPieceSquare(f.color, n));
+}
+
+/** A sparse endgame: kings, a few pieces each, and some pawns. */
+static const char* ENDGAME =
+    "8/8/8/8/4K3/8/8/8|"
+    "8/8/2P5/8/8/5P2/8/8|"
+    "8/8/8/3R4/8/8/8/8|"
+    "8/1N6/8/8/8/6b1/8/8|"
+    "8/8/8/8/3q4/8/8/8|"
+    "8/6p1/8/8/8/1u6/8/8|"
+    "8/8/3p4/8/8/8/4p3/8|"
+    "8/8/8/8/4k3/8/8/8 w - -";
+
+typedef std::chrono::steady_clock Clock;
+
+/** Runs the workload the given number of times, and returns the time taken. */
+static double timeBatch(const Workload& w, Fixture& f, Board& b, int runs,
+        long* ops)
+{
+    Clock::time_point start = Clock::now();
+    long total = 0;
+    for(int i = 0; i < runs; i++)
+        total += w.run(f, b);
+    std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+
+    *ops = total;
+    return elapsed.count();
+}
+
+/** Returns the given percentile of a sorted list of samples. */
+static double percentile(const std::vector<double>& sorted, double p)
+{
+    size_t i = (size_t) (p * (sorted.size() - 1) + 0.5);
+    return sorted[i];
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: bench [--csv] [--samples <n>] "
+            "[--filter <workload>] [--net <file>]\n");
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    bool csv = false;
+    int num_samples = 50;
+    const char* filter = NULL;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--csv") == 0)
+            csv = true;
+        else if(strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+            num_samples = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if(strcmp(argv[i], "--net") == 0 && i + 1 < argc)
+        {
+            if(!loadNetwork(argv[++i]))
+            {
+                fprintf(stderr, "bench: can't load network \"%s\"\n",
+                        argv[i]);
+                return 1;
+            }
+        }
+        else
+            usage();
+    }
+
+    if(num_samples < 1)
+        usage();
+
+    std::vector<Fixture*> fixtures;
+
+    Fixture* opening = new Fixture();
+    opening->name = "opening";
+    opening->board.setup();
+    fixtures.push_back(opening);
+
+    Fixture* middlegame = new Fixture();
+    middlegame->name = "middlegame";
+    middlegame->board.setup();
+    playMoves(middlegame->board, 40);
+    fixtures.push_back(middlegame);
+
+    Fixture* endgame = new Fixture();
+    endgame->name = "endgame";
+    if(!endgame->board.setPosition(ENDGAME))
+    {
+        fprintf(stderr, "bench: bad endgame position\n");
+        return 1;
+    }
+    fixtures.push_back(endgame);
+
+    for(size_t i = 0; i < fixtures.size(); i++)
+        prepare(*fixtures[i]);
+
+    if(csv)
+        printf("workload,position,ops,median_ns,p99_ns,ops_per_sec\n");
+    else
+        printf("%-26s %-11s %8s %12s %12s %12s\n", "workload", "position",
+                "ops", "median ns", "p99 ns", "ops/s/core");
+
+    for(int n = 0; n < NUM_WORKLOADS; n++)
+    {
+        const Workload& w = WORKLOADS[n];
+        if(filter != NULL && strcmp(filter, w.name) != 0)
+            continue;
+
+        for(size_t i = 0; i < fixtures.size(); i++)
+        {
+            Fixture& f = *fixtures[i];
+            Board b (f.board);
+            long ops;
+
+            // Warm up, doubling the batch until it takes long enough to time
+            int runs = 1;
+            while(timeBatch(w, f, b, runs, &ops) < SAMPLE_NS &&
+                  runs < (1 << 24))
+                runs *= 2;
+
+            std::vector<double> samples;
+            for(int s = 0; s < num_samples; s++)
+            {
+                double ns = timeBatch(w, f, b, runs, &ops);
+                samples.push_back(ns / ops);
+            }
+            std::sort(samples.begin(), samples.end());
+
+            double median = percentile(samples, 0.5);
+            double p99 = percentile(samples, 0.99);
+            double per_sec = 1e9 / median;
+            long ops_per_run = ops / runs;
+
+            if(csv)
+                printf("%s,%s,%ld,%.1f,%.1f,%.0f\n", w.name, f.name,
+                        ops_per_run, median, p99, per_sec);
+            else
+                printf("%-26s %-11s %8ld %12.1f %12.1f %12.0f\n", w.name,
+                        f.name, ops_per_run, median, p99, per_sec);
+            fflush(stdout);
+        }
+    }
+
+    for(size_t i = 0; i < fixtures.size(); i++)
+        delete fixtures[i];
+
+    return 0;
+}
@@ -0,0 +1,202 @@
+#include "../src/board.h"
+#include "../src/notation.h"
+#include "../src/opening-book.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Builds an opening book (see OpeningBook) from the records of games, such
+ * as self-play games, with the records split between threads. Then it opens
+ * the book it wrote, and times how long a probe takes.
+ *
+ * Each line of the records is a game: the result for White (1, 0.5 or 0, or
+ * 1-0, 1/2-1/2 or 0-1), then the moves, as notation.h writes them, separated
+ * by spaces. Only the first plies of each game go in the book, and a move
+ * that isn't legal ends the game there. Moves played fewer than min-count
+ * times are left out.
+ *
+ * Usage: book <records> <book> [--plies <n>] [--min-count <n>]
+ *             [--threads <n>]
+ */
+
+/** How many probes to time. */
+const int NUM_PROBES = 100000;
+
+typedef std::chrono::steady_clock Clock;
+
+/** Reads a result for White, or returns false if it isn't one. */
+static bool parseResult(const std::string& s, double* result)
+{
+    if(s == "1" || s == "1.0" || s == "1-0")
+        *result = 1.0;
+    else if(s == "0.5" || s == "1/2-1/2")
+        *result = 0.5;
+    else if(s == "0" || s == "0.0" || s == "0-1")
+        *result = 0.0;
+    else
+        return false;
+
+    return true;
+}
+
+/**
+ * Adds the given games to the builder. Returns 0, or the number (from 1) of
+ * the first game without a result.
+ */
+static size_t addGames(const std::vector<std::string>& games, size_t begin,
+        size_t end, int plies, BookBuilder& builder)
+{
+    for(size_t i = begin; i < end; i++)
+    {
+        std::istringstream fields (games[i]);
+        std::string word;
+        double result;
+        if(!(fields >> word) || !parseResult(word, &result))
+            return i + 1;
+
+        Board b;
+        b.setup();
+        for(int ply = 0; ply < plies && fields >> word; ply++)
+        {
+            Move m = parseMove(b, word);
+            if(m == Move())
+                break;
+
+            double score = (b.whoseTurn() == WHITE) ? result : 1 - result;
+            builder.add(b.hash(), m, score);
+            b.makeMove(m);
+        }
+    }
+
+    return 0;
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: book <records> <book> [--plies <n>] "
+            "[--min-count <n>] [--threads <n>]\n");
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<const char*> paths;
+    int plies = 20;
+    int min_count = 1;
+    int num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(argv[i][0] != '-')
+            paths.push_back(argv[i]);
+        else if(i + 1 >= argc)
+            usage();
+        else if(strcmp(argv[i], "--plies") == 0)
+            plies = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--min-count") == 0)
+            min_count = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--threads") == 0)
+            num_threads = atoi(argv[++i]);
+        else
+            usage();
+    }
+
+    if(paths.size() != 2 || plies < 1 || min_count < 1 || num_threads < 1)
+        usage();
+
+    std::ifstream in (paths[0]);
+    if(!in)
+    {
+        fprintf(stderr, "book: can't read records \"%s\"\n", paths[0]);
+        return 1;
+    }
+
+    std::vector<std::string> games;
+    std::string line;
+    while(std::getline(in, line))
+        if(!line.empty())
+            games.push_back(line);
+
+    // Each thread collects its share of the games, and then they're merged
+    Clock::time_point start = Clock::now();
+    num_threads = std::max<size_t>(1, std::min<size_t>(num_threads,
+            games.size()));
+    std::vector<BookBuilder> builders (num_threads);
+    std::vector<size_t> bad (num_threads);
+    std::vector<std::thread> threads;
+    for(int n = 0; n < num_threads; n++)
+    {
+        size_t begin = games.size() * n / num_threads;
+        size_t end = games.size() * (n + 1) / num_threads;
+        threads.push_back(std::thread([&, n, begin, end]() {
+            bad[n] = addGames(games, begin, end, plies, builders[n]);
+        }));
+    }
+    for(int n = 0; n < num_threads; n++)
+    {
+        threads[n].join();
+        if(bad[n] != 0)
+        {
+            fprintf(stderr, "book: game %zu of \"%s\" has no result\n",
+                    bad[n], paths[0]);
+            return 1;
+        }
+        if(n > 0)
+            builders[0].merge(builders[n]);
+    }
+
+    if(!builders[0].write(paths[1], min_count))
+    {
+        fprintf(stderr, "book: can't write \"%s\"\n", paths[1]);
+        return 1;
+    }
+
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    printf("Read %zu games on %d threads, and wrote %s in %.2f s\n",
+            games.size(), num_threads, paths[1], elapsed.count());
+
+    OpeningBook book;
+    if(!book.open(paths[1]))
+    {
+        fprintf(stderr, "book: can't open \"%s\"\n", paths[1]);
+        return 1;
+    }
+    printf("Entries: %zu\n", book.size());
+
+    // Half the probes are for positions in the book, and half (most likely)
+    // aren't
+    std::vector<uint64_t> keys;
+    const BookEntry* begin;
+    const BookEntry* end;
+    Board b;
+    b.setup();
+    book.probe(b.hash(), &begin, &end);
+    uint64_t key = 12345;
+    for(int n = 0; n < NUM_PROBES; n++)
+    {
+        key = key * 6364136223846793005ull + 1442695040888963407ull;
+        keys.push_back((n % 2 == 0 && begin != end) ? b.hash() : key);
+    }
+
+    start = Clock::now();
+    size_t found = 0;
+    for(int n = 0; n < NUM_PROBES; n++)
+    {
+        book.probe(keys[n], &begin, &end);
+        found += end - begin;
+    }
+    std::chrono::duration<double, std::nano> probing = Clock::now() - start;
+    printf("Probe: %.0f ns (%zu moves found)\n", probing.count() / NUM_PROBES,
+            found);
+
+    return 0;
+}
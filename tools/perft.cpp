@@ -0,0 +1,231 @@
+#include "../src/board.h"
+#include "../src/notation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Counts the leaf nodes of the legal move tree to a given depth, and prints
+ * the count under each root move ("divide"). The total is a check on move
+ * generation, and the nodes per second measure its speed.
+ *
+ * Usage: perft <depth> [--position "<position>"] [--hash <MB>]
+ *              [--threads <n>]
+ */
+
+/**
+ * A table of subtree counts, shared between threads. Each entry is a pair of
+ * words: the count (with the depth in its low byte) and the hash XORed with
+ * that. An entry torn by two threads writing at once won't check out, so no
+ * locks are needed.
+ */
+class PerftTable
+{
+  public:
+    /** Makes a table of about the given size. Zero megabytes disables it. */
+    explicit PerftTable(size_t megabytes)
+    {
+        size_ = 1;
+        while(size_ * 2 * sizeof(Entry) <= megabytes << 20)
+            size_ *= 2;
+
+        if(megabytes == 0)
+            size_ = 0;
+        else
+            entries_.reset(new Entry[size_]());
+    }
+
+    /** Looks up the count for a position and depth. Returns true if found. */
+    bool probe(uint64_t hash, int depth, uint64_t* count) const
+    {
+        if(size_ == 0)
+            return false;
+
+        const Entry& e = entries_[hash & (size_ - 1)];
+        uint64_t data = e.data.load(std::memory_order_relaxed);
+        uint64_t check = e.check.load(std::memory_order_relaxed);
+
+        if((check ^ data) != hash || (int) (data & 0xFF) != depth)
+            return false;
+
+        *count = data >> 8;
+        return true;
+    }
+
+    /** Records the count for a position and depth. */
+    void store(uint64_t hash, int depth, uint64_t count)
+    {
+        if(size_ == 0)
+            return;
+
+        Entry& e = entries_[hash & (size_ - 1)];
+        uint64_t data = (count << 8) | depth;
+        e.data.store(data, std::memory_order_relaxed);
+        e.check.store(hash ^ data, std::memory_order_relaxed);
+    }
+
+  private:
+    struct Entry
+    {
+        std::atomic<uint64_t> data;
+        std::atomic<uint64_t> check;
+    };
+
+    /** The number of entries, a power of two (or zero). */
+    size_t size_;
+
+    std::unique_ptr<Entry[]> entries_;
+};
+
+/** Returns the number of leaves depth plies below the board's position. */
+static uint64_t perft(Board& b, int depth, PerftTable& table)
+{
+    bool color = b.whoseTurn();
+    MoveList moves;
+    b.generateLegalMoves(color, moves);
+
+    // The last ply doesn't need to be made, just counted
+    if(depth == 1)
+        return moves.size();
+
+    uint64_t count;
+    if(table.probe(b.hash(), depth, &count))
+        return count;
+
+    count = 0;
+    for(const Move* it = moves.begin(); it != moves.end(); it++)
+    {
+        b.makeMove(*it);
+        count += perft(b, depth - 1, table);
+        b.undoMove();
+    }
+
+    table.store(b.hash(), depth, count);
+    return count;
+}
+
+/** The count under one root move. */
+struct Division
+{
+    std::string name;
+    uint64_t count;
+
+    bool operator<(const Division& d) const
+    {
+        return name < d.name;
+    }
+};
+
+/**
+ * Runs perft under each root move, with the given number of threads taking
+ * root moves off a shared counter.
+ */
+static std::vector<Division> divide(const Board& root, int depth,
+        int num_threads, PerftTable& table)
+{
+    MoveList moves;
+    root.generateLegalMoves(root.whoseTurn(), moves);
+
+    std::vector<Division> divisions (moves.size());
+    std::atomic<int> next (0);
+
+    auto work = [&]()
+    {
+        Board b (root);
+        for(int i = next++; i < moves.size(); i = next++)
+        {
+            divisions[i].name = moveName(moves[i]);
+
+            b.makeMove(moves[i]);
+            divisions[i].count = (depth > 1) ? perft(b, depth - 1, table) : 1;
+            b.undoMove();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for(int n = 1; n < num_threads; n++)
+        threads.push_back(std::thread(work));
+    work();
+    for(size_t n = 0; n < threads.size(); n++)
+        threads[n].join();
+
+    std::sort(divisions.begin(), divisions.end());
+    return divisions;
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: perft <depth> [--position \"<position>\"] "
+            "[--hash <MB>] [--threads <n>]\n");
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2)
+        usage();
+
+    int depth = atoi(argv[1]);
+    std::string position;
+    int hash_mb = 0;
+    int num_threads = 1;
+
+    for(int i = 2; i < argc; i++)
+    {
+        if(i + 1 >= argc)
+            usage();
+        else if(strcmp(argv[i], "--position") == 0)
+            position = argv[++i];
+        else if(strcmp(argv[i], "--hash") == 0)
+            hash_mb = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--threads") == 0)
+            num_threads = atoi(argv[++i]);
+        else
+            usage();
+    }
+
+    if(depth < 1 || hash_mb < 0 || num_threads < 1)
+        usage();
+
+    Board b;
+    if(position.empty())
+        b.setup();
+    else if(!b.setPosition(position))
+    {
+        fprintf(stderr, "perft: can't read position \"%s\"\n",
+                position.c_str());
+        return 1;
+    }
+
+    PerftTable table (hash_mb);
+
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    std::vector<Division> divisions = divide(b, depth, num_threads, table);
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    uint64_t total = 0;
+    for(size_t i = 0; i < divisions.size(); i++)
+    {
+        printf("%s: %llu\n", divisions[i].name.c_str(),
+                (unsigned long long) divisions[i].count);
+        total += divisions[i].count;
+    }
+
+    double seconds = elapsed.count();
+    printf("\nMoves: %d\n", (int) divisions.size());
+    printf("Nodes: %llu\n", (unsigned long long) total);
+    printf("Time: %.3f s\n", seconds);
+    printf("NPS: %.0f\n", (seconds > 0) ? total / seconds : 0.0);
+
+    return 0;
+}
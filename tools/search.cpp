@@ -0,0 +1,161 @@
+#include "../src/board.h"
+#include "../src/eval-params.h"
+#include "../src/history.h"
+#include "../src/nnue.h"
+#include "../src/notation.h"
+#include "../src/search.h"
+#include "../src/transposition-table.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/*
+ * Searches a position and prints the result of each iteration, to see how
+ * deep the search gets, and how fast.
+ *
+ * Usage: search [--position "<position>"] [--depth <plies>] [--nodes <n>]
+ *               [--time <ms>] [--hash <MB>] [--threads <n>]
+ *               [--param <name>=<value>]... [--net <file>] [--eval <file>]
+ *
+ * The names of the parameters are those of the members of SearchParams. With
+ * --net, the search evaluates with the network in the file (see nnue.h), and
+ * with --eval, with the handcrafted evaluation's parameters in the file (see
+ * EvalParams, and bin/tune).
+ */
+
+/** The transposition table, which the report looks at. */
+static TranspositionTable* table;
+
+static void report(const SearchResult& result)
+{
+    double nps = (result.milliseconds > 0) ?
+            result.nodes * 1000.0 / result.milliseconds : 0.0;
+
+    printf("depth %2d  score %6d  nodes %10llu  time %6d ms  nps %8.0f  pv",
+            result.depth, result.score, (unsigned long long) result.nodes,
+            result.milliseconds, nps);
+    for(size_t i = 0; i < result.pv.size(); i++)
+        printf(" %s", moveName(result.pv[i]).c_str());
+    printf("\n");
+
+    const TableStats& stats = result.table_stats;
+    printf("          table: %.1f%% hits, %.1f%% collisions, %.1f%% full\n",
+            stats.hits * 100.0 / std::max<uint64_t>(stats.probes, 1),
+            stats.collisions * 100.0 / std::max<uint64_t>(stats.stores, 1),
+            table->occupancy() * 100.0);
+    printf("          ordering: %.1f%% of cutoffs on the first move\n",
+            result.first_move_cutoffs * 100.0 /
+            std::max<uint64_t>(result.cutoffs, 1));
+    fflush(stdout);
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: search [--position \"<position>\"] "
+            "[--depth <plies>] [--nodes <n>] [--time <ms>] [--hash <MB>] "
+            "[--threads <n>] [--param <name>=<value>]... [--net <file>] "
+            "[--eval <file>]\n");
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    std::string position;
+    SearchLimits limits;
+    SearchParams params;
+    int hash_mb = 32;
+    int num_threads = 1;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(i + 1 >= argc)
+            usage();
+        else if(strcmp(argv[i], "--position") == 0)
+            position = argv[++i];
+        else if(strcmp(argv[i], "--depth") == 0)
+            limits.depth = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--nodes") == 0)
+            limits.nodes = strtoull(argv[++i], NULL, 10);
+        else if(strcmp(argv[i], "--time") == 0)
+            limits.milliseconds = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--hash") == 0)
+            hash_mb = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--threads") == 0)
+            num_threads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--param") == 0)
+        {
+            std::string param = argv[++i];
+            size_t equals = param.find('=');
+            if(equals == std::string::npos ||
+               !params.set(param.substr(0, equals),
+                       atoi(param.c_str() + equals + 1)))
+            {
+                fprintf(stderr, "search: unknown parameter \"%s\"\n",
+                        param.c_str());
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i], "--net") == 0)
+        {
+            if(!loadNetwork(argv[++i]))
+            {
+                fprintf(stderr, "search: can't load network \"%s\"\n",
+                        argv[i]);
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i], "--eval") == 0)
+        {
+            EvalParams eval;
+            if(!eval.load(argv[++i]))
+            {
+                fprintf(stderr, "search: can't read parameters \"%s\"\n",
+                        argv[i]);
+                return 1;
+            }
+            setEvalParams(eval);
+        }
+        else
+            usage();
+    }
+
+    if(limits.depth < 1 || limits.milliseconds < 0 || hash_mb < 0 ||
+       num_threads < 1)
+        usage();
+
+    Board b;
+    if(position.empty())
+        b.setup();
+    else if(!b.setPosition(position))
+    {
+        fprintf(stderr, "search: can't read position \"%s\"\n",
+                position.c_str());
+        return 1;
+    }
+
+    table = new TranspositionTable(hash_mb);
+    table->newSearch();
+
+    std::vector<History> histories (num_threads);
+    std::atomic<bool> stop (false);
+    SearchResult result = parallelSearch(b, *table, histories, limits, params,
+            stop, report);
+
+    if(result.best_move == Move())
+        printf("No legal moves\n");
+    else
+        printf("Best move: %s\n", moveName(result.best_move).c_str());
+
+    // Including the helpers' nodes
+    double seconds = result.milliseconds / 1000.0;
+    printf("Nodes: %llu\n", (unsigned long long) result.nodes);
+    printf("NPS: %.0f\n", (seconds > 0) ? result.nodes / seconds : 0.0);
+
+    delete table;
+    return 0;
+}
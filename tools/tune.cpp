@@ -0,0 +1,412 @@
+#include "../src/board.h"
+#include "../src/eval-params.h"
+#include "../src/evaluate.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * Tunes the handcrafted evaluation (see EvalParams) to predict the results of
+ * games, as in Texel's tuning method: the score of each position, through a
+ * sigmoid, should come out as the result of the game it's from. The error is
+ * the mean squared difference, and the parameters follow its gradient with
+ * Adam, a full pass over the positions (an epoch) per step.
+ *
+ * The evaluation is linear in the parameters, so each position is traced once
+ * (see traceEvaluation), by the evaluation's own code, into how much each
+ * parameter counts towards it. An epoch is then just a short sum for each
+ * position, split between threads, so even millions of positions take
+ * seconds.
+ *
+ * Each line of the dataset is a position, as Board::getPosition writes it,
+ * then the result for White: 1, 0.5 or 0 (or 1-0, 1/2-1/2 or 0-1). The tuned
+ * parameters are written out every so often, and at the end, to be read with
+ * --eval by bin/search and bin/bench, or with EvalParams::load.
+ *
+ * Usage: tune <dataset> [--out <file>] [--params <file>] [--epochs <n>]
+ *             [--rate <r>] [--threads <n>] [--k <k>]
+ */
+
+/** How often, in epochs, to report the error and save the parameters. */
+const int REPORT_EVERY = 25;
+
+/** One parameter's coefficient in one position. */
+struct Term
+{
+    uint16_t param;
+    int16_t coef;
+};
+
+/** The traced positions, or some of them. */
+struct Dataset
+{
+    /** Position i's terms are terms[starts[i]] up to terms[starts[i + 1]]. */
+    std::vector<Term> terms;
+    std::vector<size_t> starts;
+
+    /** How much of each position's score is the middlegame's, from 0 to 1. */
+    std::vector<float> phases;
+
+    /** The results, for White. */
+    std::vector<float> results;
+
+    size_t size() const
+    {
+        return results.size();
+    }
+};
+
+/**
+ * The parameters being tuned, or something of the same shape, indexed by
+ * EvalParam and then by middlegame (0) or endgame (1).
+ */
+struct Weights
+{
+    double values [NUM_EVAL_PARAMS][2];
+};
+
+typedef std::chrono::steady_clock Clock;
+
+/** Reads a result, or returns false if it isn't one. */
+static bool parseResult(const std::string& s, float* result)
+{
+    if(s == "1" || s == "1.0" || s == "1-0")
+        *result = 1.0f;
+    else if(s == "0.5" || s == "1/2-1/2")
+        *result = 0.5f;
+    else if(s == "0" || s == "0.0" || s == "0-1")
+        *result = 0.0f;
+    else
+        return false;
+
+    return true;
+}
+
+/**
+ * Traces the given lines into the dataset. Returns 0, or the number (from 1)
+ * of the first position that can't be read.
+ */
+static size_t traceLines(const std::vector<std::string>& lines, size_t begin,
+        size_t end, Dataset& data)
+{
+    Board b;
+    EvalTrace trace;
+    for(size_t i = begin; i < end; i++)
+    {
+        const std::string& line = lines[i];
+        size_t space = line.find_last_of(' ');
+        float result;
+        if(space == std::string::npos ||
+           !parseResult(line.substr(space + 1), &result) ||
+           !b.setPosition(line.substr(0, space)))
+            return i + 1;
+
+        traceEvaluation(b, trace);
+        data.starts.push_back(data.terms.size());
+        for(int param = 0; param < NUM_EVAL_PARAMS; param++)
+        {
+            if(trace.coefs[param] != 0)
+            {
+                Term t = { (uint16_t) param, (int16_t) trace.coefs[param] };
+                data.terms.push_back(t);
+            }
+        }
+        data.phases.push_back((float) trace.phase / MAX_PHASE);
+        data.results.push_back(result);
+    }
+
+    data.starts.push_back(data.terms.size());
+    return 0;
+}
+
+/** Returns the score of position i with the given weights, for White. */
+static double score(const Dataset& data, size_t i, const Weights& w)
+{
+    double mg = 0, eg = 0;
+    for(size_t t = data.starts[i]; t < data.starts[i + 1]; t++)
+    {
+        const Term& term = data.terms[t];
+        mg += term.coef * w.values[term.param][0];
+        eg += term.coef * w.values[term.param][1];
+    }
+
+    return mg * data.phases[i] + eg * (1 - data.phases[i]);
+}
+
+/** The sigmoid that turns a score into an expected result. */
+static double sigmoid(double k, double score)
+{
+    return 1.0 / (1.0 + pow(10.0, -k * score / 400.0));
+}
+
+/**
+ * Adds the squared errors of the dataset's positions to error, and (if
+ * gradient isn't NULL) their gradients to gradient.
+ */
+static void accumulateError(const Dataset& data, const Weights& w, double k,
+        double* error, Weights* gradient)
+{
+    for(size_t i = 0; i < data.size(); i++)
+    {
+        double s = sigmoid(k, score(data, i, w));
+        double diff = s - data.results[i];
+        *error += diff * diff;
+        if(gradient == NULL)
+            continue;
+
+        // The derivative of the squared error with respect to the score
+        double d = 2 * diff * s * (1 - s) * log(10.0) * k / 400.0;
+        double phase = data.phases[i];
+        for(size_t t = data.starts[i]; t < data.starts[i + 1]; t++)
+        {
+            const Term& term = data.terms[t];
+            gradient->values[term.param][0] += d * term.coef * phase;
+            gradient->values[term.param][1] += d * term.coef * (1 - phase);
+        }
+    }
+}
+
+/**
+ * Returns the mean squared error over all the datasets, each on its own
+ * thread, and fills in its gradient if that isn't NULL.
+ */
+static double meanError(const std::vector<Dataset>& parts, const Weights& w,
+        double k, Weights* gradient)
+{
+    std::vector<double> errors (parts.size(), 0.0);
+    std::vector<Weights> gradients (parts.size());
+    std::vector<std::thread> threads;
+    for(size_t n = 0; n < parts.size(); n++)
+    {
+        memset(&gradients[n], 0, sizeof(Weights));
+        threads.push_back(std::thread(accumulateError, std::cref(parts[n]),
+                std::cref(w), k, &errors[n],
+                (gradient != NULL) ? &gradients[n] : NULL));
+    }
+
+    double error = 0;
+    size_t count = 0;
+    if(gradient != NULL)
+        memset(gradient, 0, sizeof(Weights));
+    for(size_t n = 0; n < parts.size(); n++)
+    {
+        threads[n].join();
+        error += errors[n];
+        count += parts[n].size();
+        for(int p = 0; gradient != NULL && p < NUM_EVAL_PARAMS; p++)
+        {
+            gradient->values[p][0] += gradients[n].values[p][0];
+            gradient->values[p][1] += gradients[n].values[p][1];
+        }
+    }
+
+    for(int p = 0; gradient != NULL && p < NUM_EVAL_PARAMS; p++)
+    {
+        gradient->values[p][0] /= count;
+        gradient->values[p][1] /= count;
+    }
+    return error / count;
+}
+
+/**
+ * Returns the k for which the sigmoid best fits the results with the given
+ * weights, searching between 0 and 10.
+ */
+static double fitK(const std::vector<Dataset>& parts, const Weights& w)
+{
+    double lo = 0.0, hi = 10.0;
+    for(int n = 0; n < 40; n++)
+    {
+        double a = lo + (hi - lo) / 3, b = hi - (hi - lo) / 3;
+        if(meanError(parts, w, a, NULL) < meanError(parts, w, b, NULL))
+            hi = b;
+        else
+            lo = a;
+    }
+
+    return (lo + hi) / 2;
+}
+
+/** Rounds the weights into parameters. */
+static EvalParams toParams(const Weights& w)
+{
+    EvalParams params;
+    for(int p = 0; p < NUM_EVAL_PARAMS; p++)
+        params.scores[p] = Score((int) lround(w.values[p][0]),
+                                 (int) lround(w.values[p][1]));
+
+    return params;
+}
+
+static void usage()
+{
+    fprintf(stderr, "usage: tune <dataset> [--out <file>] [--params <file>] "
+            "[--epochs <n>] [--rate <r>] [--threads <n>] [--k <k>]\n");
+    exit(1);
+}
+
+int main(int argc, char** argv)
+{
+    const char* dataset = NULL;
+    std::string out = "eval-params.txt";
+    EvalParams start;
+    int epochs = 500;
+    double rate = 1.0;
+    int num_threads = std::max(1u, std::thread::hardware_concurrency());
+    double k = 0;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(argv[i][0] != '-' && dataset == NULL)
+            dataset = argv[i];
+        else if(i + 1 >= argc)
+            usage();
+        else if(strcmp(argv[i], "--out") == 0)
+            out = argv[++i];
+        else if(strcmp(argv[i], "--params") == 0)
+        {
+            if(!start.load(argv[++i]))
+            {
+                fprintf(stderr, "tune: can't read parameters \"%s\"\n",
+                        argv[i]);
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i], "--epochs") == 0)
+            epochs = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--rate") == 0)
+            rate = atof(argv[++i]);
+        else if(strcmp(argv[i], "--threads") == 0)
+            num_threads = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--k") == 0)
+            k = atof(argv[++i]);
+        else
+            usage();
+    }
+
+    if(dataset == NULL || epochs < 0 || rate <= 0 || num_threads < 1 ||
+       k < 0)
+        usage();
+
+    std::ifstream in (dataset);
+    if(!in)
+    {
+        fprintf(stderr, "tune: can't read dataset \"%s\"\n", dataset);
+        return 1;
+    }
+
+    std::vector<std::string> lines;
+    std::string line;
+    while(std::getline(in, line))
+        if(!line.empty())
+            lines.push_back(line);
+    if(lines.empty())
+    {
+        fprintf(stderr, "tune: no positions in \"%s\"\n", dataset);
+        return 1;
+    }
+
+    // Trace the positions in parallel, and keep each thread's share apart for
+    // the epochs as well
+    Clock::time_point start_time = Clock::now();
+    num_threads = std::min<size_t>(num_threads, lines.size());
+    std::vector<Dataset> parts (num_threads);
+    std::vector<size_t> bad (num_threads);
+    std::vector<std::thread> threads;
+    for(int n = 0; n < num_threads; n++)
+    {
+        size_t begin = lines.size() * n / num_threads;
+        size_t end = lines.size() * (n + 1) / num_threads;
+        threads.push_back(std::thread([&, n, begin, end]() {
+            bad[n] = traceLines(lines, begin, end, parts[n]);
+        }));
+    }
+    for(int n = 0; n < num_threads; n++)
+    {
+        threads[n].join();
+        if(bad[n] != 0)
+        {
+            fprintf(stderr, "tune: can't read position %zu of \"%s\"\n",
+                    bad[n], dataset);
+            return 1;
+        }
+    }
+
+    std::chrono::duration<double> elapsed = Clock::now() - start_time;
+    printf("Traced %zu positions on %d threads in %.2f s\n", lines.size(),
+            num_threads, elapsed.count());
+    std::vector<std::string>().swap(lines);
+    fflush(stdout);
+
+    Weights w;
+    for(int p = 0; p < NUM_EVAL_PARAMS; p++)
+    {
+        w.values[p][0] = start.scores[p].mg;
+        w.values[p][1] = start.scores[p].eg;
+    }
+
+    if(k == 0)
+        k = fitK(parts, w);
+    printf("k = %.4f, error = %.6f\n", k, meanError(parts, w, k, NULL));
+    fflush(stdout);
+
+    // Adam, with the usual decay rates
+    const double BETA1 = 0.9, BETA2 = 0.999, EPSILON = 1e-8;
+    Weights m, v, gradient;
+    memset(&m, 0, sizeof(Weights));
+    memset(&v, 0, sizeof(Weights));
+
+    start_time = Clock::now();
+    for(int epoch = 1; epoch <= epochs; epoch++)
+    {
+        double error = meanError(parts, w, k, &gradient);
+
+        double correction1 = 1 - pow(BETA1, epoch);
+        double correction2 = 1 - pow(BETA2, epoch);
+        for(int p = 0; p < NUM_EVAL_PARAMS; p++)
+        {
+            for(int j = 0; j < 2; j++)
+            {
+                double g = gradient.values[p][j];
+                double& mean = m.values[p][j];
+                double& square = v.values[p][j];
+                mean = BETA1 * mean + (1 - BETA1) * g;
+                square = BETA2 * square + (1 - BETA2) * g * g;
+                w.values[p][j] -= rate * (mean / correction1) /
+                        (sqrt(square / correction2) + EPSILON);
+            }
+        }
+
+        if(epoch % REPORT_EVERY == 0)
+        {
+            elapsed = Clock::now() - start_time;
+            printf("epoch %5d  error %.6f  %.3f s/epoch\n", epoch, error,
+                    elapsed.count() / epoch);
+            fflush(stdout);
+
+            if(!toParams(w).save(out))
+            {
+                fprintf(stderr, "tune: can't write \"%s\"\n", out.c_str());
+                return 1;
+            }
+        }
+    }
+
+    if(!toParams(w).save(out))
+    {
+        fprintf(stderr, "tune: can't write \"%s\"\n", out.c_str());
+        return 1;
+    }
+
+    printf("Final error %.6f, written to %s\n", meanError(parts, w, k, NULL),
+            out.c_str());
+    return 0;
+}